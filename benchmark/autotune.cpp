@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../gsaca-double-sort/mapped_text.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds-auto.hpp"
+#include "../gsaca-double-sort/verify.hpp"
+#include "corpora.hpp"
+
+// Autotuner for gsaca_ds_auto.
+//
+// Runs every combination of phase 1 sorter, phase 2 sorter, flag usage and
+// initial sort prefix length (i.e. every instantiation of gsaca_ds that
+// gsaca_ds_configured can dispatch to) on the sample inputs, and checks the
+// resulting suffix arrays with verify_sa. Sample inputs are the given
+// files (which must not contain zero bytes); without files, the synthetic
+// corpora are used at the given sizes. Each measurement is the median of the
+// repetitions and is printed as a RESULT line.
+//
+// Inputs are grouped into classes by length (up to 2^20, up to 2^24, larger)
+// and alphabet size (up to 16, larger). For every class with samples, the
+// configuration with the smallest sum of slowdowns relative to the fastest
+// configuration per input is chosen; the overall best configuration serves
+// as fallback. With --emit-profile=<file>, the result is written in the
+// format of gsaca-double-sort/auto_profile.hpp, which it is meant to replace.
+//
+// usage: autotune [--sizes=1048576,16777216] [--reps=3]
+//                 [--corpora=dna,random,zipf,repetitive,fibonacci]
+//                 [--prefixes=1,2,3] [--emit-profile=<file>] [files...]
+
+namespace {
+
+using gsaca_lyndon::gsaca_config;
+using gsaca_lyndon::sorter_id_names;
+
+constexpr size_t size_classes[] = {1ULL << 20, 1ULL << 24, SIZE_MAX};
+constexpr size_t sigma_classes[] = {16, SIZE_MAX};
+constexpr size_t class_count = 6;
+
+struct options {
+  std::vector<size_t> sizes = {1ULL << 20, 1ULL << 24};
+  size_t reps = 3;
+  std::vector<std::string> corpora = {"dna", "random", "zipf", "repetitive",
+                                      "fibonacci"};
+  std::vector<size_t> prefixes = {1, 2, 3};
+  std::vector<std::string> files;
+  std::string profile;
+};
+
+struct sample {
+  std::string name;
+  size_t n;
+  size_t sigma;
+  std::vector<double> seconds; // one per configuration
+};
+
+std::vector<std::string> split(std::string const &list) {
+  std::vector<std::string> result;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) result.push_back(item);
+  return result;
+}
+
+std::vector<gsaca_config> all_configs(options const &opt) {
+  std::vector<gsaca_config> result;
+  for (uint8_t p1 = 0; p1 < gsaca_lyndon::sorter_id_count; ++p1) {
+    for (uint8_t p2 = 0; p2 < gsaca_lyndon::sorter_id_count; ++p2) {
+      for (bool const flags : {true, false}) {
+        for (size_t const prefix : opt.prefixes) {
+          result.push_back(gsaca_config{p1, p2, flags, false,
+                                        (uint8_t) prefix});
+        }
+      }
+    }
+  }
+  return result;
+}
+
+std::string config_name(gsaca_config const &config) {
+  return std::string("p1=") + sorter_id_names[config.p1_sorter] +
+         " p2=" + sorter_id_names[config.p2_sorter] +
+         " flags=" + (config.use_flags ? "1" : "0") +
+         " prefix=" + std::to_string(config.prefix);
+}
+
+size_t class_of(size_t const n, size_t const sigma) {
+  size_t s = 0, a = 0;
+  while (n > size_classes[s]) ++s;
+  while (sigma > sigma_classes[a]) ++a;
+  return s * 2 + a;
+}
+
+sample measure(std::string const &name, uint8_t const *const text,
+               size_t const n, std::vector<gsaca_config> const &configs,
+               options const &opt) {
+  sample result{name, n, gsaca_lyndon::auto_internal::alphabet_size(text, n),
+                {}};
+  uint32_t *const sa = (uint32_t *) malloc(n * sizeof(uint32_t));
+
+  for (auto const &config : configs) {
+    std::vector<double> runs;
+    for (size_t r = 0; r < opt.reps; ++r) {
+      auto const begin = std::chrono::steady_clock::now();
+      gsaca_lyndon::gsaca_ds_configured(text, sa, n, config);
+      runs.push_back(std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - begin).count());
+    }
+    std::sort(runs.begin(), runs.end());
+    double const seconds = runs[runs.size() / 2];
+    bool const correct = gsaca_lyndon::verify_sa_parallel(text, sa, n, 0);
+    // incorrect configurations are never chosen
+    result.seconds.push_back(correct ? seconds : 1e300);
+    std::cout << "RESULT input=" << name << " n=" << n
+              << " sigma=" << result.sigma << " " << config_name(config)
+              << " seconds=" << seconds
+              << " correct=" << (correct ? "1" : "0") << std::endl;
+  }
+  free(sa);
+  return result;
+}
+
+// index of the configuration with the smallest sum of slowdowns over the
+// samples of the given class (or over all samples if cls == class_count)
+size_t best_config(std::vector<sample> const &samples, size_t const configs,
+                   size_t const cls) {
+  std::vector<double> score(configs, 0);
+  for (auto const &s : samples) {
+    if (cls != class_count && class_of(s.n, s.sigma) != cls) continue;
+    double const fastest = *std::min_element(s.seconds.begin(),
+                                             s.seconds.end());
+    for (size_t c = 0; c < configs; ++c) score[c] += s.seconds[c] / fastest;
+  }
+  return std::min_element(score.begin(), score.end()) - score.begin();
+}
+
+void emit_profile(std::vector<sample> const &samples,
+                  std::vector<gsaca_config> const &configs,
+                  options const &opt) {
+  FILE *const file = fopen(opt.profile.c_str(), "w");
+  if (file == nullptr) {
+    std::cerr << "cannot write " << opt.profile << std::endl;
+    std::exit(1);
+  }
+  auto const print_entry = [&](size_t const max_n, size_t const max_sigma,
+                               gsaca_config const &config, bool const last) {
+      auto const print_size = [&](size_t const value) {
+          if (value == SIZE_MAX) fprintf(file, "SIZE_MAX");
+          else fprintf(file, "%zu", value);
+      };
+      fprintf(file, "    {");
+      print_size(max_n);
+      fprintf(file, ", ");
+      print_size(max_sigma);
+      fprintf(file, ", {sorter_id_%s, sorter_id_%s, %s, false, %u}}%s\n",
+              sorter_id_names[config.p1_sorter],
+              sorter_id_names[config.p2_sorter],
+              config.use_flags ? "true" : "false",
+              (unsigned) config.prefix, last ? "};" : ",");
+  };
+
+  fprintf(file,
+          "#pragma once\n\n"
+          "// Configuration profile of gsaca_ds_auto, generated by\n"
+          "// benchmark/autotune --emit-profile from %zu sample inputs.\n\n"
+          "#include \"auto_config.hpp\"\n\n"
+          "namespace gsaca_lyndon {\nnamespace auto_profile {\n\n"
+          "constexpr char const *machine = \"generated\";\n"
+          "constexpr gsaca_profile_entry entries[] = {\n",
+          samples.size());
+  for (size_t cls = 0; cls < class_count; ++cls) {
+    bool sampled = false;
+    for (auto const &s : samples) sampled |= (class_of(s.n, s.sigma) == cls);
+    if (!sampled) continue;
+    print_entry(size_classes[cls / 2], sigma_classes[cls % 2],
+                configs[best_config(samples, configs.size(), cls)], false);
+  }
+  print_entry(SIZE_MAX, SIZE_MAX,
+              configs[best_config(samples, configs.size(), class_count)],
+              true);
+  fprintf(file, "\n} // namespace auto_profile\n"
+                "} // namespace gsaca_lyndon\n");
+  fclose(file);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    std::string const value = arg.substr(arg.find('=') + 1);
+    if (arg.rfind("--sizes=", 0) == 0) {
+      opt.sizes.clear();
+      for (auto const &s : split(value)) opt.sizes.push_back(std::stoull(s));
+    } else if (arg.rfind("--reps=", 0) == 0) {
+      opt.reps = std::max(1ULL, std::stoull(value));
+    } else if (arg.rfind("--corpora=", 0) == 0) {
+      opt.corpora = split(value);
+    } else if (arg.rfind("--prefixes=", 0) == 0) {
+      opt.prefixes.clear();
+      for (auto const &p : split(value)) {
+        opt.prefixes.push_back(std::min(3ULL, std::max(1ULL, std::stoull(p))));
+      }
+    } else if (arg.rfind("--emit-profile=", 0) == 0) {
+      opt.profile = value;
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "unknown argument " << arg << std::endl;
+      return 1;
+    } else {
+      opt.files.push_back(arg);
+    }
+  }
+
+  auto const configs = all_configs(opt);
+  std::vector<sample> samples;
+  if (opt.files.empty()) {
+    for (auto const &corpus_name : opt.corpora) {
+      int const corpus = corpora::corpus_by_name(corpus_name);
+      if (corpus < 0) {
+        std::cerr << "unknown corpus " << corpus_name << std::endl;
+        continue;
+      }
+      for (size_t const n : opt.sizes) {
+        if (n < 1024 || n >= (1ULL << 32)) {
+          std::cerr << "sizes must be in [1024, 2^32)" << std::endl;
+          return 1;
+        }
+        uint8_t *const text = corpora::generate((corpora::corpus_type) corpus,
+                                                n);
+        samples.push_back(measure(corpus_name, text, n, configs, opt));
+        free(text);
+      }
+    }
+  } else {
+    for (auto const &path : opt.files) {
+      gsaca_lyndon::mapped_text const text(path.c_str());
+      if (!text || text.size() >= (1ULL << 32)) {
+        std::cerr << "cannot use " << path << std::endl;
+        continue;
+      }
+      if (memchr(text.text() + 1, 0, text.size() - 2) != nullptr) {
+        std::cerr << path << " contains zero bytes" << std::endl;
+        continue;
+      }
+      samples.push_back(measure(path, text.text(), text.size(), configs, opt));
+    }
+  }
+
+  if (samples.empty()) {
+    std::cerr << "no sample inputs" << std::endl;
+    return 1;
+  }
+  auto const best = configs[best_config(samples, configs.size(), class_count)];
+  std::cout << "BEST " << config_name(best) << std::endl;
+  if (!opt.profile.empty()) emit_profile(samples, configs, opt);
+  return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+g++ scaling.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o scaling
+
+g++ sorters.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o sorters
+
+g++ autotune.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o autotune
+
+g++ regress.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o regress
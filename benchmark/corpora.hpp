@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Synthetic benchmark corpora. All texts use the sentinel convention of the
+// library: text[0] = text[n - 1] = 0 and no other zeros.
+
+namespace corpora {
+
+enum corpus_type : uint32_t {
+  random_dna = 0,     // uniform over 4 symbols
+  random_bytes = 1,   // uniform over 255 symbols
+  zipf = 2,           // skewed over 96 symbols, roughly like natural text
+  repetitive = 3,     // copies of a 64 KiB block with 0.1% mutations
+  fibonacci = 4,      // Fibonacci word, extremely repetitive
+  corpus_count = 5
+};
+
+constexpr char const *corpus_names[corpus_count] = {
+    "dna", "random", "zipf", "repetitive", "fibonacci"};
+
+inline int corpus_by_name(std::string const &name) {
+  for (uint32_t c = 0; c < corpus_count; ++c) {
+    if (name == corpus_names[c]) return c;
+  }
+  return -1;
+}
+
+// returns a malloc'ed text of length n >= 3
+inline uint8_t *generate(corpus_type const corpus, size_t const n,
+                         uint64_t const seed = 42) {
+  uint8_t *const text = (uint8_t *) malloc(n);
+  std::mt19937_64 rng(seed);
+  uint8_t *const interior = text + 1;
+  size_t const m = n - 2;
+
+  switch (corpus) {
+    case random_dna:
+      for (size_t i = 0; i < m; ++i) interior[i] = 'A' + (rng() & 3);
+      break;
+    case random_bytes:
+      for (size_t i = 0; i < m; ++i) interior[i] = 1 + rng() % 255;
+      break;
+    case zipf: {
+      std::vector<double> weights(96);
+      for (size_t i = 0; i < weights.size(); ++i) weights[i] = 1.0 / (i + 1);
+      std::discrete_distribution<uint32_t> dist(weights.begin(), weights.end());
+      for (size_t i = 0; i < m; ++i) interior[i] = 32 + dist(rng);
+      break;
+    }
+    case repetitive: {
+      size_t const block = std::min(m, (size_t) 1 << 16);
+      for (size_t i = 0; i < block; ++i) interior[i] = 'a' + rng() % 26;
+      for (size_t i = block; i < m; ++i) {
+        interior[i] = (rng() % 1000 == 0) ? ('a' + rng() % 26)
+                                          : interior[i - block];
+      }
+      break;
+    }
+    default: {
+      // the Fibonacci word is the limit of s_k = s_{k-1} s_{k-2}; its i-th
+      // symbol is b iff floor((i + 2) / phi) - floor((i + 1) / phi) == 0
+      double const phi = (1 + std::sqrt(5.0)) / 2;
+      for (size_t i = 0; i < m; ++i) {
+        interior[i] = ((size_t) ((i + 2) / phi) - (size_t) ((i + 1) / phi))
+                      ? 'a' : 'b';
+      }
+    }
+  }
+  text[0] = text[n - 1] = 0;
+  return text;
+}
+
+} // namespace corpora
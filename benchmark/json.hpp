@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal JSON values for benchmark result files: null, booleans, numbers
+// (as double), strings without unicode escapes, arrays and objects. Parsing
+// fails (returns false) on anything else.
+
+namespace json {
+
+struct value {
+  enum kind_type { null, boolean, number, string, array, object };
+
+  kind_type kind = null;
+  double num = 0;
+  std::string str;
+  std::vector<value> items;
+  std::map<std::string, value> members;
+
+  bool has(std::string const &key) const {
+    return kind == object && members.count(key) > 0;
+  }
+
+  value const &operator[](std::string const &key) const {
+    static value const missing;
+    auto const it = members.find(key);
+    return (it == members.end()) ? missing : it->second;
+  }
+};
+
+namespace internal {
+
+inline void skip_space(char const *&p) {
+  while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') ++p;
+}
+
+inline bool parse_string(char const *&p, std::string &out) {
+  if (*p != '"') return false;
+  ++p;
+  while (*p != '"') {
+    if (*p == '\0') return false;
+    if (*p == '\\') {
+      ++p;
+      switch (*p) {
+        case 'n': out.push_back('\n'); break;
+        case 't': out.push_back('\t'); break;
+        case '"': case '\\': case '/': out.push_back(*p); break;
+        default: return false;
+      }
+      ++p;
+    } else {
+      out.push_back(*p++);
+    }
+  }
+  ++p;
+  return true;
+}
+
+inline bool parse_value(char const *&p, value &out) {
+  skip_space(p);
+  if (*p == '{') {
+    out.kind = value::object;
+    ++p;
+    skip_space(p);
+    if (*p == '}') return ++p, true;
+    while (true) {
+      std::string key;
+      skip_space(p);
+      if (!parse_string(p, key)) return false;
+      skip_space(p);
+      if (*p++ != ':') return false;
+      if (!parse_value(p, out.members[key])) return false;
+      skip_space(p);
+      if (*p == '}') return ++p, true;
+      if (*p++ != ',') return false;
+    }
+  } else if (*p == '[') {
+    out.kind = value::array;
+    ++p;
+    skip_space(p);
+    if (*p == ']') return ++p, true;
+    while (true) {
+      out.items.emplace_back();
+      if (!parse_value(p, out.items.back())) return false;
+      skip_space(p);
+      if (*p == ']') return ++p, true;
+      if (*p++ != ',') return false;
+    }
+  } else if (*p == '"') {
+    out.kind = value::string;
+    return parse_string(p, out.str);
+  } else if (std::string(p, 4) == "null") {
+    p += 4;
+    return true;
+  } else if (std::string(p, 4) == "true" || std::string(p, 5) == "false") {
+    out.kind = value::boolean;
+    out.num = (*p == 't');
+    p += (*p == 't') ? 4 : 5;
+    return true;
+  }
+  char *end;
+  out.kind = value::number;
+  out.num = std::strtod(p, &end);
+  if (end == p) return false;
+  p = end;
+  return true;
+}
+
+}
+
+inline bool parse(std::string const &text, value &out) {
+  char const *p = text.c_str();
+  if (!internal::parse_value(p, out)) return false;
+  internal::skip_space(p);
+  return *p == '\0';
+}
+
+inline bool read_file(char const *const path, value &out) {
+  FILE *const file = fopen(path, "r");
+  if (file == nullptr) return false;
+  std::string text;
+  char buffer[1 << 16];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    text.append(buffer, read);
+  }
+  fclose(file);
+  return parse(text, out);
+}
+
+// quoted string; result files only contain plain identifiers and paths
+inline std::string quote(std::string const &s) {
+  std::string result = "\"";
+  for (char const c : s) {
+    if (c == '"' || c == '\\') result.push_back('\\');
+    result.push_back(c);
+  }
+  return result + "\"";
+}
+
+inline std::string number_array(std::vector<double> const &values) {
+  std::string result = "[";
+  char buffer[32];
+  for (size_t i = 0; i < values.size(); ++i) {
+    snprintf(buffer, sizeof(buffer), "%.9g", values[i]);
+    result += (i > 0 ? ", " : "") + std::string(buffer);
+  }
+  return result + "]";
+}
+
+} // namespace json
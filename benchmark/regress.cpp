@@ -0,0 +1,356 @@
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../gsaca-double-sort/stats.hpp"
+#include "../gsaca-double-sort/parallel/gsaca-ds-par.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds-hash.hpp"
+#include "../gsaca-double-sort/verify.hpp"
+#include "corpora.hpp"
+#include "json.hpp"
+
+// Performance regression gate.
+//
+// Record mode runs every variant on every corpus reps times and stores all
+// run times (total and per phase) as a JSON baseline. Compare mode reruns
+// the configuration of a baseline (or loads a second result file with
+// --current) and compares each variant, corpus and phase: the ratio of the
+// median times (current / baseline) gets a bootstrapped confidence interval,
+// obtained by resampling both sets of runs. A difference is significant if
+// the whole interval lies beyond the threshold, e.g. a regression if the
+// lower bound exceeds 1 + threshold. Output is a diff table; the exit code is
+// 1 if there is a significant regression (or an incorrect suffix array).
+//
+// usage: regress --record=<file> [--n=16777216] [--threads=<omp max>]
+//                [--reps=10] [--corpora=dna,random,zipf,repetitive,fibonacci]
+//                [--variants=ds1,ds2,ds3,dsh,ds1_par,ds2_par,ds3_par]
+//        regress --baseline=<file> [--current=<file>] [--save=<file>]
+//                [--threshold=0.02] [--confidence=0.95] [--resamples=2000]
+
+namespace {
+
+using gsaca_lyndon::gsaca_phase;
+using gsaca_lyndon::gsaca_phase_count;
+using gsaca_lyndon::gsaca_phase_names;
+using gsaca_lyndon::gsaca_stats;
+using gsaca_lyndon::stats_observer;
+
+constexpr size_t metric_count = gsaca_phase_count + 1;
+
+struct options {
+  std::string record;
+  std::string baseline;
+  std::string current;
+  std::string save;
+  size_t n = 1ULL << 24;
+  size_t threads = omp_get_max_threads();
+  size_t reps = 10;
+  std::vector<std::string> corpora = {"dna", "random", "zipf", "repetitive",
+                                      "fibonacci"};
+  std::vector<std::string> variants = {"ds1", "ds2", "ds3", "dsh",
+                                       "ds1_par", "ds2_par", "ds3_par"};
+  double threshold = 0.02;
+  double confidence = 0.95;
+  size_t resamples = 2000;
+};
+
+// all runs of one variant on one corpus; metric 0 is the total time,
+// metric 1 + p the time of phase p (empty for variants without phases)
+struct result {
+  std::string variant;
+  std::string corpus;
+  std::vector<double> seconds[metric_count];
+  bool correct = true;
+};
+
+struct result_file {
+  size_t n;
+  size_t threads;
+  size_t reps;
+  std::vector<result> results;
+};
+
+std::string metric_name(size_t const metric) {
+  return (metric == 0) ? "total" : gsaca_phase_names[metric - 1];
+}
+
+std::vector<std::string> split(std::string const &list) {
+  std::vector<std::string> result;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) result.push_back(item);
+  return result;
+}
+
+void construct(std::string const &variant, uint8_t const *const text,
+               uint32_t *const sa, size_t const n, size_t const threads,
+               gsaca_stats &stats) {
+  stats_observer const observer{{}, &stats};
+  if (variant == "dsh") {
+    gsaca_lyndon::gsaca_hash_ds(text, sa, n);
+  } else if (variant.size() > 3 && variant.substr(3) == "_par") {
+    size_t const algo = variant[2] - '0';
+    // same flag settings as gsaca_ds{1,2,3}_par
+    if (algo == 1) {
+      gsaca_lyndon::gsaca_ds_par<gsaca_lyndon::auto_buffer_type, false>(
+          text, sa, n, threads, 1, observer);
+    } else {
+      gsaca_lyndon::gsaca_ds_par(text, sa, n, threads, algo, observer);
+    }
+  } else {
+    gsaca_lyndon::gsaca_ds<gsaca_lyndon::MSD, gsaca_lyndon::MSD>(
+        text, sa, n, variant[2] - '0', observer);
+  }
+}
+
+bool valid_variant(std::string const &variant) {
+  return variant == "dsh" ||
+         ((variant.size() == 3 || variant.substr(3) == "_par") &&
+          variant.rfind("ds", 0) == 0 && variant[2] >= '1' &&
+          variant[2] <= '3');
+}
+
+result_file run(result_file config, std::vector<std::string> const &corpus_list,
+                std::vector<std::string> const &variant_list) {
+  uint32_t *const sa = (uint32_t *) malloc(config.n * sizeof(uint32_t));
+  for (auto const &corpus_name : corpus_list) {
+    int const corpus = corpora::corpus_by_name(corpus_name);
+    if (corpus < 0) {
+      std::cerr << "unknown corpus " << corpus_name << std::endl;
+      continue;
+    }
+    uint8_t *const text = corpora::generate((corpora::corpus_type) corpus,
+                                            config.n);
+    for (auto const &variant : variant_list) {
+      if (!valid_variant(variant)) {
+        std::cerr << "unknown variant " << variant << std::endl;
+        continue;
+      }
+      result r;
+      r.variant = variant;
+      r.corpus = corpus_name;
+      for (size_t rep = 0; rep < config.reps; ++rep) {
+        gsaca_stats stats = {};
+        auto const begin = std::chrono::steady_clock::now();
+        construct(variant, text, sa, config.n, config.threads, stats);
+        r.seconds[0].push_back(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - begin).count());
+        if (variant != "dsh") {
+          for (size_t p = 0; p < gsaca_phase_count; ++p) {
+            r.seconds[p + 1].push_back(stats.phase[p].seconds);
+          }
+        }
+      }
+      r.correct = gsaca_lyndon::verify_sa_parallel(text, sa, config.n,
+                                                   config.threads);
+      std::cerr << "ran " << variant << " on " << corpus_name
+                << (r.correct ? "" : " (INCORRECT)") << std::endl;
+      config.results.push_back(r);
+    }
+    free(text);
+  }
+  free(sa);
+  return config;
+}
+
+bool write_results(std::string const &path, result_file const &file) {
+  FILE *const out = fopen(path.c_str(), "w");
+  if (out == nullptr) return false;
+  fprintf(out, "{\n  \"n\": %zu,\n  \"threads\": %zu,\n  \"reps\": %zu,\n"
+               "  \"results\": [",
+          file.n, file.threads, file.reps);
+  for (size_t i = 0; i < file.results.size(); ++i) {
+    auto const &r = file.results[i];
+    fprintf(out, "%s\n    {\"variant\": %s, \"corpus\": %s, \"correct\": %s",
+            (i > 0) ? "," : "", json::quote(r.variant).c_str(),
+            json::quote(r.corpus).c_str(), r.correct ? "true" : "false");
+    for (size_t m = 0; m < metric_count; ++m) {
+      if (r.seconds[m].empty()) continue;
+      fprintf(out, ",\n     %s: %s", json::quote(metric_name(m)).c_str(),
+              json::number_array(r.seconds[m]).c_str());
+    }
+    fprintf(out, "}");
+  }
+  fprintf(out, "\n  ]\n}\n");
+  return fclose(out) == 0;
+}
+
+bool read_results(std::string const &path, result_file &file) {
+  json::value root;
+  if (!json::read_file(path.c_str(), root) || !root.has("results")) {
+    return false;
+  }
+  file.n = root["n"].num;
+  file.threads = root["threads"].num;
+  file.reps = root["reps"].num;
+  for (auto const &item : root["results"].items) {
+    result r;
+    r.variant = item["variant"].str;
+    r.corpus = item["corpus"].str;
+    r.correct = !item.has("correct") || item["correct"].num != 0;
+    for (size_t m = 0; m < metric_count; ++m) {
+      for (auto const &v : item[metric_name(m)].items) {
+        r.seconds[m].push_back(v.num);
+      }
+    }
+    file.results.push_back(r);
+  }
+  return true;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t const k = values.size() / 2;
+  return (values.size() % 2) ? values[k] : (values[k - 1] + values[k]) / 2;
+}
+
+// bootstrapped confidence interval of median(current) / median(baseline)
+std::pair<double, double> ratio_interval(std::vector<double> const &baseline,
+                                         std::vector<double> const &current,
+                                         options const &opt) {
+  std::mt19937_64 rng(1);
+  std::vector<double> ratios(opt.resamples);
+  std::vector<double> b(baseline.size()), c(current.size());
+  for (auto &ratio : ratios) {
+    for (auto &x : b) x = baseline[rng() % baseline.size()];
+    for (auto &x : c) x = current[rng() % current.size()];
+    ratio = median(c) / median(b);
+  }
+  std::sort(ratios.begin(), ratios.end());
+  double const tail = (1 - opt.confidence) / 2;
+  size_t const lo = tail * (opt.resamples - 1);
+  size_t const hi = (1 - tail) * (opt.resamples - 1);
+  return {ratios[lo], ratios[hi]};
+}
+
+// prints the diff table and returns whether the current results pass
+bool compare(result_file const &baseline, result_file const &current,
+             options const &opt) {
+  printf("%-8s %-11s %-15s %10s %10s %7s %17s  %s\n", "variant", "corpus",
+         "metric", "base[s]", "curr[s]", "ratio", "ci", "verdict");
+  size_t regressions = 0, improvements = 0, incorrect = 0;
+  for (auto const &cur : current.results) {
+    incorrect += !cur.correct;
+    for (auto const &base : baseline.results) {
+      if (base.variant != cur.variant || base.corpus != cur.corpus) continue;
+      for (size_t m = 0; m < metric_count; ++m) {
+        if (base.seconds[m].empty() || cur.seconds[m].empty()) continue;
+        double const b = median(base.seconds[m]);
+        double const c = median(cur.seconds[m]);
+        auto const ci = ratio_interval(base.seconds[m], cur.seconds[m], opt);
+        char const *verdict = "~";
+        if (ci.first > 1 + opt.threshold) {
+          verdict = "REGRESSION";
+          ++regressions;
+        } else if (ci.second < 1 - opt.threshold) {
+          verdict = "improvement";
+          ++improvements;
+        }
+        if (!cur.correct) verdict = "INCORRECT";
+        printf("%-8s %-11s %-15s %10.4f %10.4f %7.3f   [%5.3f, %5.3f]  %s\n",
+               cur.variant.c_str(), cur.corpus.c_str(),
+               metric_name(m).c_str(), b, c, c / b, ci.first, ci.second,
+               verdict);
+      }
+    }
+  }
+  printf("%zu regressions, %zu improvements, %zu incorrect "
+         "(threshold %.1f%%, %.0f%% confidence)\n",
+         regressions, improvements, incorrect, opt.threshold * 100,
+         opt.confidence * 100);
+  if (baseline.n != current.n || baseline.threads != current.threads) {
+    printf("warning: baseline n=%zu threads=%zu, current n=%zu threads=%zu\n",
+           baseline.n, baseline.threads, current.n, current.threads);
+  }
+  return regressions == 0 && incorrect == 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    std::string const value = arg.substr(arg.find('=') + 1);
+    if (arg.rfind("--record=", 0) == 0) {
+      opt.record = value;
+    } else if (arg.rfind("--baseline=", 0) == 0) {
+      opt.baseline = value;
+    } else if (arg.rfind("--current=", 0) == 0) {
+      opt.current = value;
+    } else if (arg.rfind("--save=", 0) == 0) {
+      opt.save = value;
+    } else if (arg.rfind("--n=", 0) == 0) {
+      opt.n = std::stoull(value);
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      opt.threads = std::stoull(value);
+    } else if (arg.rfind("--reps=", 0) == 0) {
+      opt.reps = std::max(2ULL, std::stoull(value));
+    } else if (arg.rfind("--corpora=", 0) == 0) {
+      opt.corpora = split(value);
+    } else if (arg.rfind("--variants=", 0) == 0) {
+      opt.variants = split(value);
+    } else if (arg.rfind("--threshold=", 0) == 0) {
+      opt.threshold = std::stod(value);
+    } else if (arg.rfind("--confidence=", 0) == 0) {
+      opt.confidence = std::stod(value);
+    } else if (arg.rfind("--resamples=", 0) == 0) {
+      opt.resamples = std::max(100ULL, std::stoull(value));
+    } else {
+      std::cerr << "unknown argument " << arg << std::endl;
+      return 2;
+    }
+  }
+
+  if (!opt.record.empty()) {
+    if (opt.n < 1024 || opt.n >= (1ULL << 32)) {
+      std::cerr << "n must be in [1024, 2^32)" << std::endl;
+      return 2;
+    }
+    auto const results = run(result_file{opt.n, opt.threads, opt.reps, {}},
+                             opt.corpora, opt.variants);
+    if (!write_results(opt.record, results)) {
+      std::cerr << "cannot write " << opt.record << std::endl;
+      return 2;
+    }
+    return 0;
+  }
+
+  if (opt.baseline.empty()) {
+    std::cerr << "either --record or --baseline is required" << std::endl;
+    return 2;
+  }
+  result_file baseline = {};
+  if (!read_results(opt.baseline, baseline)) {
+    std::cerr << "cannot read " << opt.baseline << std::endl;
+    return 2;
+  }
+  result_file current = {};
+  if (!opt.current.empty()) {
+    if (!read_results(opt.current, current)) {
+      std::cerr << "cannot read " << opt.current << std::endl;
+      return 2;
+    }
+  } else {
+    // rerun exactly the configurations of the baseline
+    std::vector<std::string> corpus_list, variant_list;
+    for (auto const &r : baseline.results) {
+      if (std::find(corpus_list.begin(), corpus_list.end(), r.corpus) ==
+          corpus_list.end()) corpus_list.push_back(r.corpus);
+      if (std::find(variant_list.begin(), variant_list.end(), r.variant) ==
+          variant_list.end()) variant_list.push_back(r.variant);
+    }
+    current = run(result_file{baseline.n, baseline.threads, baseline.reps, {}},
+                  corpus_list, variant_list);
+    if (!opt.save.empty() && !write_results(opt.save, current)) {
+      std::cerr << "cannot write " << opt.save << std::endl;
+    }
+  }
+  return compare(baseline, current, opt) ? 0 : 1;
+}
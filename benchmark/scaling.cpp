@@ -0,0 +1,248 @@
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../gsaca-double-sort/stats.hpp"
+#include "../gsaca-double-sort/parallel/gsaca-ds-par.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds-hash.hpp"
+#include "../gsaca-double-sort/verify.hpp"
+#include "corpora.hpp"
+
+// Strong and weak scaling of gsaca_ds{1,2,3}_par.
+//
+// For every corpus, the sequential variants (gsaca_ds{1,2,3}, gsaca_dsh) are
+// measured first; the fastest one is the baseline. Strong scaling sorts a
+// text of fixed length n with 1, 2, 4, ... up to the maximum number of
+// threads, weak scaling sorts a text of length n / max_threads * threads.
+// Each measurement is the median of the repetitions. Output consists of
+// RESULT lines (one per measurement) and PHASE lines (the per-phase
+// breakdown of the median run, see write_stats), as key=value pairs. Every
+// suffix array is checked with verify_sa_parallel (not timed); the exit code
+// is nonzero if any of them is incorrect.
+//
+// usage: scaling [--n=67108864] [--threads=<omp max>] [--reps=3]
+//                [--corpora=dna,random,zipf,repetitive,fibonacci]
+//                [--algos=ds1,ds2,ds3] [--counters]
+
+namespace {
+
+using gsaca_lyndon::gsaca_stats;
+using gsaca_lyndon::perf_counters;
+using gsaca_lyndon::stats_observer;
+
+struct measurement {
+  double seconds;
+  gsaca_stats stats;
+  bool correct;
+};
+
+struct options {
+  size_t n = 1ULL << 26;
+  size_t threads = omp_get_max_threads();
+  size_t reps = 3;
+  std::vector<std::string> corpora = {"dna", "random", "zipf", "repetitive",
+                                      "fibonacci"};
+  std::vector<size_t> algos = {1, 2, 3};
+  bool counters = false;
+};
+
+std::vector<std::string> split(std::string const &list) {
+  std::vector<std::string> result;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) result.push_back(item);
+  return result;
+}
+
+// runs the construction reps times and returns the median run
+template<typename function_type>
+measurement median_of(size_t const reps, function_type &&construct) {
+  std::vector<measurement> runs;
+  for (size_t r = 0; r < reps; ++r) {
+    measurement m = {};
+    auto const begin = std::chrono::steady_clock::now();
+    construct(m.stats);
+    m.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin).count();
+    runs.push_back(m);
+  }
+  std::sort(runs.begin(), runs.end(),
+            [](measurement const &a, measurement const &b) {
+                return a.seconds < b.seconds;
+            });
+  return runs[runs.size() / 2];
+}
+
+measurement run_sequential(uint8_t const *const text, uint32_t *const sa,
+                           size_t const n, size_t const algo,
+                           options const &opt) {
+  std::unique_ptr<perf_counters> counters(
+      opt.counters ? new perf_counters(1) : nullptr);
+  auto m = median_of(opt.reps, [&](gsaca_stats &stats) {
+      if (algo == 0) {
+        gsaca_lyndon::gsaca_hash_ds(text, sa, n);
+      } else {
+        gsaca_lyndon::gsaca_ds<gsaca_lyndon::MSD, gsaca_lyndon::MSD>(
+            text, sa, n, algo, stats_observer{{}, &stats, counters.get()});
+      }
+  });
+  m.correct = gsaca_lyndon::verify_sa_parallel(text, sa, n, opt.threads);
+  return m;
+}
+
+measurement run_parallel(uint8_t const *const text, uint32_t *const sa,
+                         size_t const n, size_t const algo,
+                         size_t const threads, options const &opt) {
+  std::unique_ptr<perf_counters> counters(
+      opt.counters ? new perf_counters(threads) : nullptr);
+  auto m = median_of(opt.reps, [&](gsaca_stats &stats) {
+      stats_observer const observer{{}, &stats, counters.get()};
+      // same flag settings as gsaca_ds{1,2,3}_par
+      if (algo == 1) {
+        gsaca_lyndon::gsaca_ds_par<gsaca_lyndon::auto_buffer_type, false>(
+            text, sa, n, threads, 1, observer);
+      } else {
+        gsaca_lyndon::gsaca_ds_par(text, sa, n, threads, algo, observer);
+      }
+  });
+  m.correct = gsaca_lyndon::verify_sa_parallel(text, sa, n, opt.threads);
+  return m;
+}
+
+std::string sequential_name(size_t const algo) {
+  return (algo == 0) ? "dsh" : "ds" + std::to_string(algo);
+}
+
+void print_phases(std::string const &prefix, measurement const &m) {
+  write_stats(std::cout, m.stats, ("PHASE " + prefix + " ").c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    std::string const value = arg.substr(arg.find('=') + 1);
+    if (arg.rfind("--n=", 0) == 0) {
+      opt.n = std::stoull(value);
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      opt.threads = std::stoull(value);
+    } else if (arg.rfind("--reps=", 0) == 0) {
+      opt.reps = std::max(1ULL, std::stoull(value));
+    } else if (arg.rfind("--corpora=", 0) == 0) {
+      opt.corpora = split(value);
+    } else if (arg.rfind("--algos=", 0) == 0) {
+      opt.algos.clear();
+      for (auto const &a : split(value)) opt.algos.push_back(a.back() - '0');
+    } else if (arg == "--counters") {
+      opt.counters = true;
+    } else {
+      std::cerr << "unknown argument " << arg << std::endl;
+      return 1;
+    }
+  }
+  if (opt.n < 1024 || opt.n >= (1ULL << 32)) {
+    std::cerr << "n must be in [1024, 2^32)" << std::endl;
+    return 1;
+  }
+
+  std::vector<size_t> thread_counts;
+  for (size_t p = 1; p < opt.threads; p <<= 1) thread_counts.push_back(p);
+  thread_counts.push_back(opt.threads);
+
+  size_t const weak_n = std::max((size_t) 1024, opt.n / opt.threads);
+  size_t const max_n = std::max(opt.n, weak_n * opt.threads);
+  uint32_t *const sa = (uint32_t *) malloc(max_n * sizeof(uint32_t));
+  bool all_correct = true;
+
+  for (auto const &corpus_name : opt.corpora) {
+    int const corpus = corpora::corpus_by_name(corpus_name);
+    if (corpus < 0) {
+      std::cerr << "unknown corpus " << corpus_name << std::endl;
+      continue;
+    }
+
+    // sequential baselines, for the strong (n) and weak (n / threads) sizes
+    double baseline[2] = {1e300, 1e300};
+    size_t const sizes[2] = {opt.n, weak_n};
+    for (size_t s = 0; s < 2; ++s) {
+      uint8_t *const text = corpora::generate((corpora::corpus_type) corpus,
+                                              sizes[s]);
+      for (size_t const algo : {1, 2, 3, 0}) {
+        auto const m = run_sequential(text, sa, sizes[s], algo, opt);
+        baseline[s] = std::min(baseline[s], m.seconds);
+        std::string const prefix =
+            "benchmark=sequential corpus=" + corpus_name +
+            " n=" + std::to_string(sizes[s]) +
+            " algo=" + sequential_name(algo);
+        all_correct &= m.correct;
+        std::cout << "RESULT " << prefix << " seconds=" << m.seconds
+                  << " correct=" << m.correct << std::endl;
+        if (algo != 0) print_phases(prefix, m);
+      }
+      free(text);
+    }
+
+    // strong scaling
+    uint8_t *const text = corpora::generate((corpora::corpus_type) corpus,
+                                            opt.n);
+    for (size_t const algo : opt.algos) {
+      double self_baseline = 0;
+      for (size_t const p : thread_counts) {
+        auto const m = run_parallel(text, sa, opt.n, algo, p, opt);
+        if (p == 1) self_baseline = m.seconds;
+        double const speedup = baseline[0] / m.seconds;
+        std::string const prefix =
+            "benchmark=strong corpus=" + corpus_name +
+            " n=" + std::to_string(opt.n) +
+            " algo=ds" + std::to_string(algo) + "_par" +
+            " threads=" + std::to_string(p);
+        std::cout << "RESULT " << prefix << " seconds=" << m.seconds
+                  << " baseline_seconds=" << baseline[0]
+                  << " speedup=" << speedup
+                  << " efficiency=" << speedup / p
+                  << " self_speedup=" << self_baseline / m.seconds
+                  << " correct=" << m.correct << std::endl;
+        all_correct &= m.correct;
+        print_phases(prefix, m);
+      }
+    }
+    free(text);
+
+    // weak scaling: the sequential baseline for n_p = p * weak_n is
+    // extrapolated linearly from the one for weak_n
+    for (size_t const algo : opt.algos) {
+      double self_baseline = 0;
+      for (size_t const p : thread_counts) {
+        size_t const n = weak_n * p;
+        uint8_t *const weak_text =
+            corpora::generate((corpora::corpus_type) corpus, n);
+        auto const m = run_parallel(weak_text, sa, n, algo, p, opt);
+        free(weak_text);
+        if (p == 1) self_baseline = m.seconds;
+        std::string const prefix =
+            "benchmark=weak corpus=" + corpus_name +
+            " n=" + std::to_string(n) +
+            " algo=ds" + std::to_string(algo) + "_par" +
+            " threads=" + std::to_string(p);
+        std::cout << "RESULT " << prefix << " seconds=" << m.seconds
+                  << " mib_per_second=" << n / m.seconds / (1 << 20)
+                  << " efficiency=" << baseline[1] / m.seconds
+                  << " self_efficiency=" << self_baseline / m.seconds
+                  << " correct=" << m.correct << std::endl;
+        all_correct &= m.correct;
+        print_phases(prefix, m);
+      }
+    }
+  }
+
+  free(sa);
+  if (!all_correct) std::cerr << "incorrect suffix arrays" << std::endl;
+  return all_correct ? 0 : 1;
+}
@@ -0,0 +1,338 @@
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../gsaca-double-sort/radix32.hpp"
+
+// Microbenchmark of the key/value sorters used by the engine: insertion
+// sort, MSD and LSD radix sort, and IPS4O (sequential and parallel).
+//
+// Sweeps the group size, the key range (max_key), the key/value width
+// (uint32, uint40, uint64) and the key distribution. Groups are sorted
+// increasingly (as in phase 2); small groups are sorted many times, such
+// that every measurement covers at least 2^22 elements. Output is one RESULT
+// line per measurement (nanoseconds per element).
+//
+// With --emit-table=<file>, a tuning table for the engine is derived from
+// the uniform distribution and written in the format of
+// gsaca-double-sort/sorter_tuning.hpp, which it is meant to replace.
+//
+// usage: sorters [--min-size=8] [--max-size=100000000] [--step=4]
+//                [--widths=32,40,64] [--dists=uniform,skewed,presorted,dups]
+//                [--threads=<omp max>] [--emit-table=<file>]
+
+namespace {
+
+using gsaca_lyndon::radix_key_val_pair;
+
+enum distribution : uint32_t {
+  uniform = 0,
+  skewed = 1,
+  presorted = 2,
+  duplicates = 3,
+  distribution_count = 4
+};
+
+constexpr char const *distribution_names[distribution_count] = {
+    "uniform", "skewed", "presorted", "dups"};
+
+enum sorter_type : uint32_t {
+  sorter_insertion = 0,
+  sorter_msd = 1,
+  sorter_lsd = 2,
+  sorter_ips4o = 3,
+  sorter_ips4o_par = 4,
+  sorter_count = 5
+};
+
+constexpr char const *sorter_names[sorter_count] = {
+    "insertion", "msd", "lsd", "ips4o", "ips4o_par"};
+
+struct options {
+  size_t min_size = 8;
+  size_t max_size = 100000000;
+  size_t step = 4;
+  std::vector<size_t> widths = {32, 40, 64};
+  std::vector<size_t> dists = {uniform, skewed, presorted, duplicates};
+  size_t threads = omp_get_max_threads();
+  std::string table;
+};
+
+// ns per element, by (key bytes, size) and sorter, uniform keys only
+using table_input = std::map<std::pair<size_t, size_t>,
+                             std::map<size_t, double>>;
+
+std::vector<std::string> split(std::string const &list) {
+  std::vector<std::string> result;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) result.push_back(item);
+  return result;
+}
+
+template<typename key_type>
+void generate(radix_key_val_pair<key_type> *const data, size_t const size,
+              size_t const groups, uint64_t const max_key,
+              distribution const dist, std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> real(0, 1);
+  for (size_t g = 0; g < groups; ++g) {
+    auto *const group = data + g * size;
+    for (size_t i = 0; i < size; ++i) {
+      uint64_t key;
+      switch (dist) {
+        case skewed:
+          key = (uint64_t) (std::pow(real(rng), 4) * max_key);
+          break;
+        case duplicates:
+          key = (max_key / 15) * (rng() % 16);
+          break;
+        default:
+          key = (max_key == UINT64_MAX) ? rng() : rng() % (max_key + 1);
+      }
+      group[i].key = key;
+      group[i].value = (uint64_t) (g * size + i);
+    }
+    if (dist == presorted) {
+      std::sort(group, group + size, [](auto const &a, auto const &b) {
+          return a.key < b.key;
+      });
+    }
+  }
+}
+
+template<typename key_type>
+double measure(sorter_type const sorter, size_t const size,
+               uint64_t const max_key, distribution const dist,
+               size_t const threads) {
+  using pair_type = radix_key_val_pair<key_type>;
+  size_t const groups = std::max((size_t) 1, ((size_t) 1 << 22) / size);
+  size_t const total = groups * size;
+
+  // one element of space to the left, as insertion sort expects
+  pair_type *const memory = (pair_type *) malloc((total + 1) * sizeof(pair_type));
+  pair_type *const data = memory + 1;
+  pair_type *const buffer = (pair_type *) malloc(size * sizeof(pair_type));
+  std::mt19937_64 rng(size * 31 + dist);
+  generate(data, size, groups, max_key, dist, rng);
+
+  auto const begin = std::chrono::steady_clock::now();
+  for (size_t g = 0; g < groups; ++g) {
+    pair_type *const group = data + g * size;
+    switch (sorter) {
+      case sorter_insertion:
+        gsaca_lyndon::radix_internal::insertion<true>(group, size);
+        break;
+      case sorter_msd:
+        gsaca_lyndon::MSD::sort<true, false>(group, buffer, size, max_key);
+        break;
+      case sorter_lsd:
+        gsaca_lyndon::LSD::sort<true, false>(group, buffer, size, max_key);
+        break;
+      case sorter_ips4o:
+        gsaca_lyndon::IPS4O::sort<true, false>(group, buffer, size, max_key);
+        break;
+      default:
+        ips4o::parallel::sort(group, group + size,
+                              [](pair_type const &a, pair_type const &b) {
+                                  return a.key < b.key;
+                              }, threads);
+    }
+  }
+  double const seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  for (size_t i = 1; i < size; ++i) {
+    if (data[i - 1].key > data[i].key) {
+      std::cerr << "sorter " << sorter_names[sorter] << " failed" << std::endl;
+      std::exit(1);
+    }
+  }
+  free(buffer);
+  free(memory);
+  return seconds * 1e9 / total;
+}
+
+template<typename key_type>
+void sweep(size_t const width, options const &opt, table_input &table) {
+  std::vector<uint64_t> max_keys = {0xFFULL, 0xFFFFULL, 0xFFFFFFULL,
+                                    0xFFFFFFFFULL};
+  if (width >= 40) max_keys.push_back(0xFFFFFFFFFFULL);
+  if (width == 64) max_keys.push_back(UINT64_MAX);
+
+  for (size_t const dist : opt.dists) {
+    for (uint64_t const max_key : max_keys) {
+      size_t const key_bytes = (71 - __builtin_clzl(max_key)) >> 3;
+      for (size_t size = opt.min_size; size <= opt.max_size;
+           size *= opt.step) {
+        for (uint32_t s = 0; s < sorter_count; ++s) {
+          // skip hopeless configurations
+          if (s == sorter_insertion && size > 1024) continue;
+          if (s == sorter_ips4o_par && (size < 1024 || opt.threads < 2)) {
+            continue;
+          }
+          double const ns = measure<key_type>((sorter_type) s, size, max_key,
+                                              (distribution) dist,
+                                              opt.threads);
+          std::cout << "RESULT benchmark=sorters width=" << width
+                    << " max_key=" << max_key << " key_bytes=" << key_bytes
+                    << " dist=" << distribution_names[dist]
+                    << " size=" << size << " sorter=" << sorter_names[s]
+                    << " threads=" << ((s == sorter_ips4o_par)
+                                       ? opt.threads : 1)
+                    << " ns_per_element=" << ns << std::endl;
+          // the engine's buffer type has the width of the keys
+          bool const matching_width =
+              (key_bytes <= 4) ? (width == 32) : (key_bytes == 5)
+                                                 ? (width == 40)
+                                                 : (width == 64);
+          if (dist == uniform && matching_width) {
+            table[{key_bytes, size}][s] = ns;
+          }
+        }
+      }
+    }
+  }
+}
+
+// smallest measured size from which on the challenger always wins
+size_t min_winning_size(table_input const &table, size_t const key_bytes,
+                        size_t const challenger,
+                        std::vector<size_t> const &incumbents) {
+  size_t result = SIZE_MAX;
+  for (auto it = table.rbegin(); it != table.rend(); ++it) {
+    if (it->first.first != key_bytes) continue;
+    auto const &times = it->second;
+    if (times.count(challenger) == 0) break;
+    bool wins = true;
+    for (size_t const incumbent : incumbents) {
+      if (times.count(incumbent) > 0 &&
+          times.at(incumbent) <= times.at(challenger)) {
+        wins = false;
+      }
+    }
+    if (!wins) break;
+    result = it->first.second;
+  }
+  return result;
+}
+
+void emit_table(table_input const &table, options const &opt) {
+  // insertion sort threshold: the largest size at which insertion sort is
+  // still faster than MSD radix sort (which uses it for small buckets)
+  size_t insertion_threshold = 0;
+  for (auto const &entry : table) {
+    auto const &times = entry.second;
+    if (entry.first.first == 4 && times.count(sorter_insertion) > 0 &&
+        times.at(sorter_insertion) < times.at(sorter_msd)) {
+      insertion_threshold = std::max(insertion_threshold, entry.first.second);
+    }
+  }
+
+  size_t lsd[9], ips4o[9];
+  size_t parallel_threshold = SIZE_MAX;
+  for (size_t b = 0; b < 9; ++b) {
+    lsd[b] = min_winning_size(table, b, sorter_lsd, {sorter_msd});
+    ips4o[b] = min_winning_size(table, b, sorter_ips4o,
+                                {sorter_msd, sorter_lsd});
+    parallel_threshold = std::min(
+        parallel_threshold,
+        min_winning_size(table, b, sorter_ips4o_par,
+                         {sorter_msd, sorter_lsd, sorter_ips4o}));
+  }
+  // key widths that were not measured use the next smaller measured one
+  for (size_t b = 1; b < 9; ++b) {
+    bool measured = false;
+    for (auto const &entry : table) measured |= (entry.first.first == b);
+    if (!measured) {
+      lsd[b] = lsd[b - 1];
+      ips4o[b] = ips4o[b - 1];
+    }
+  }
+
+  FILE *const file = fopen(opt.table.c_str(), "w");
+  if (file == nullptr) {
+    std::cerr << "cannot write " << opt.table << std::endl;
+    std::exit(1);
+  }
+  auto const print_array = [&](char const *const name, size_t const *values) {
+      fprintf(file, "constexpr size_t %s[9] = {\n   ", name);
+      for (size_t b = 0; b < 9; ++b) {
+        if (values[b] == SIZE_MAX) fprintf(file, " SIZE_MAX");
+        else fprintf(file, " %zu", values[b]);
+        fprintf(file, (b < 8) ? "," : "};\n");
+        if (b == 4) fprintf(file, "\n   ");
+      }
+  };
+  fprintf(file,
+          "#pragma once\n\n"
+          "// Sorter tuning table, generated by benchmark/sorters --emit-table.\n"
+          "// Entries are indexed by the number of key bytes; a size of SIZE_MAX\n"
+          "// means never.\n\n"
+          "#include <cstddef>\n#include <cstdint>\n\n"
+          "namespace gsaca_lyndon {\nnamespace sorter_tuning {\n\n"
+          "constexpr char const *machine = \"generated, %zu threads\";\n"
+          "constexpr size_t insertion_threshold = %zu;\n",
+          opt.threads, std::max((size_t) 8, insertion_threshold));
+  if (parallel_threshold == SIZE_MAX) {
+    fprintf(file, "constexpr size_t parallel_threshold = SIZE_MAX;\n");
+  } else {
+    fprintf(file, "constexpr size_t parallel_threshold = %zu;\n",
+            parallel_threshold);
+  }
+  print_array("lsd_min_size", lsd);
+  print_array("ips4o_min_size", ips4o);
+  fprintf(file, "\n} // namespace sorter_tuning\n"
+                "} // namespace gsaca_lyndon\n");
+  fclose(file);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    std::string const value = arg.substr(arg.find('=') + 1);
+    if (arg.rfind("--min-size=", 0) == 0) {
+      opt.min_size = std::max(2ULL, std::stoull(value));
+    } else if (arg.rfind("--max-size=", 0) == 0) {
+      opt.max_size = std::stoull(value);
+    } else if (arg.rfind("--step=", 0) == 0) {
+      opt.step = std::max(2ULL, std::stoull(value));
+    } else if (arg.rfind("--widths=", 0) == 0) {
+      opt.widths.clear();
+      for (auto const &w : split(value)) opt.widths.push_back(std::stoull(w));
+    } else if (arg.rfind("--dists=", 0) == 0) {
+      opt.dists.clear();
+      for (auto const &d : split(value)) {
+        for (size_t k = 0; k < distribution_count; ++k) {
+          if (d == distribution_names[k]) opt.dists.push_back(k);
+        }
+      }
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      opt.threads = std::stoull(value);
+    } else if (arg.rfind("--emit-table=", 0) == 0) {
+      opt.table = value;
+    } else {
+      std::cerr << "unknown argument " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  table_input table;
+  for (size_t const width : opt.widths) {
+    if (width == 32) sweep<uint32_t>(width, opt, table);
+    else if (width == 40) sweep<gsaca_lyndon::uint40_t>(width, opt, table);
+    else if (width == 64) sweep<uint64_t>(width, opt, table);
+    else std::cerr << "unsupported width " << width << std::endl;
+  }
+  if (!opt.table.empty()) emit_table(table, opt);
+  return 0;
+}
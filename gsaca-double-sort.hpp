@@ -2,6 +2,7 @@
 
 #include "gsaca-double-sort/sequential/gsaca-ds.hpp"
 #include "gsaca-double-sort/sequential/gsaca-ds-hash.hpp"
+#include "gsaca-double-sort/sequential/gsaca-ds-auto.hpp"
 
 template<typename index_type, typename value_type>
 static void gsaca_ds1(value_type const *const text, 
@@ -31,3 +32,10 @@ static void gsaca_dsh(value_type const *const text,
                       size_t const n) {
   gsaca_lyndon::gsaca_hash_ds(text, sa, n);
 }
+
+template<typename index_type, typename value_type>
+static void gsaca_ds_auto(value_type const *const text,
+                          index_type *const sa,
+                          size_t const n) {
+  gsaca_lyndon::gsaca_ds_auto(text, sa, n);
+}
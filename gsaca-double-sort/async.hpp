@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include "parallel/gsaca-ds-par.hpp"
+#include "sequential/gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+enum class gsaca_stage : uint32_t {
+  queued,
+  sort_by_prefix,
+  phase_1,
+  phase_2,
+  done,
+  cancelled
+};
+
+struct gsaca_progress {
+  gsaca_stage stage;
+  // fraction of the current stage that is done: the share of suffixes that
+  // have been assigned their final group (phase 1), or whose position in the
+  // suffix array is final (phase 2)
+  double fraction;
+};
+
+namespace async_internal {
+
+struct job_state {
+  std::atomic<gsaca_stage> stage{gsaca_stage::queued};
+  std::atomic<uint64_t> done{0};
+  std::atomic<uint64_t> total{1};
+  std::atomic<bool> stop{false};
+};
+
+// Publishes progress roughly every 1/1024 of a phase, such that the shared
+// counters are not written for every group.
+struct progress_observer : no_observer {
+  job_state *state;
+  gsaca_stage stage = gsaca_stage::sort_by_prefix;
+  uint64_t next_report = 0;
+
+  gsaca_always_inline void report(gsaca_stage const current,
+                                  uint64_t const done, uint64_t const total) {
+    if (gsaca_unlikely(done >= next_report || stage != current)) {
+      if (stage != current) {
+        stage = current;
+        state->total.store(total, std::memory_order_relaxed);
+        state->stage.store(current, std::memory_order_relaxed);
+      }
+      state->done.store(done, std::memory_order_relaxed);
+      next_report = done + (total >> 10);
+    }
+  }
+
+  gsaca_always_inline void phase_1_progress(size_t const assigned,
+                                            size_t const n) {
+    report(gsaca_stage::phase_1, assigned, n);
+  }
+
+  template<typename index_type>
+  gsaca_always_inline void phase_2_progress(index_type const *const,
+                                            size_t const border) {
+    report(gsaca_stage::phase_2, border, state->total.load(
+        std::memory_order_relaxed));
+  }
+
+  gsaca_always_inline bool stop_requested() const {
+    return state->stop.load(std::memory_order_relaxed);
+  }
+};
+
+} // namespace async_internal
+
+// Handle of a suffix array construction running in the background. The
+// construction can be cancelled cooperatively: it stops at the next group
+// boundary of phase 1 or phase 2 and releases all internal buffers. After
+// cancellation the content of the suffix array is unspecified. Destroying an
+// unfinished job cancels it and waits until it has stopped, because the
+// caller owns the text and the suffix array. A default-constructed or
+// moved-from job is not valid(): it reports no progress, cannot be cancelled
+// and is never ready; wait() returns false.
+class gsaca_job {
+public:
+  gsaca_job() = default;
+
+  gsaca_job(gsaca_job &&) = default;
+
+  gsaca_job &operator=(gsaca_job &&other) {
+    if (this != &other) {
+      cancel_and_wait();
+      state_ = std::move(other.state_);
+      result_ = std::move(other.result_);
+    }
+    return *this;
+  }
+
+  ~gsaca_job() {
+    cancel_and_wait();
+  }
+
+  bool valid() const {
+    return state_ != nullptr;
+  }
+
+  gsaca_progress progress() const {
+    if (!valid()) return {gsaca_stage::queued, 0.0};
+    uint64_t const done = state_->done.load(std::memory_order_relaxed);
+    uint64_t const total = state_->total.load(std::memory_order_relaxed);
+    return {state_->stage.load(std::memory_order_relaxed),
+            std::min(1.0, (double) done / total)};
+  }
+
+  void cancel() {
+    if (valid()) state_->stop.store(true, std::memory_order_relaxed);
+  }
+
+  bool ready() const {
+    return result_.valid() &&
+           result_.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  }
+
+  // returns true if the suffix array is complete, false if it was cancelled
+  bool wait() {
+    return result_.valid() && result_.get();
+  }
+
+  std::shared_future<bool> future() const {
+    return result_;
+  }
+
+private:
+  template<typename function_type>
+  friend gsaca_job run_async(function_type &&);
+
+  void cancel_and_wait() {
+    if (result_.valid()) {
+      cancel();
+      result_.wait();
+    }
+  }
+
+  std::shared_ptr<async_internal::job_state> state_;
+  std::shared_future<bool> result_;
+};
+
+template<typename function_type>
+gsaca_job run_async(function_type &&construct) {
+  gsaca_job job;
+  job.state_ = std::make_shared<async_internal::job_state>();
+  auto state = job.state_;
+  job.result_ = std::async(std::launch::async, [state, construct] {
+      state->stage = gsaca_stage::sort_by_prefix;
+      construct(async_internal::progress_observer{{}, state.get()});
+      bool const completed = !state->stop.load();
+      state->done = state->total.load();
+      state->stage = completed ? gsaca_stage::done : gsaca_stage::cancelled;
+      return completed;
+  }).share();
+  return job;
+}
+
+template<typename buffer_type = auto_buffer_type,
+    bool use_flags = true,
+    typename index_type, // auto deduce
+    typename value_type>
+static gsaca_job
+gsaca_ds_par_async(value_type const *const text, index_type *const sa,
+                   size_t const n, size_t const threads,
+                   size_t const initial_sort_prefix_len = 1) {
+  return run_async([=](async_internal::progress_observer observer) {
+      gsaca_ds_par<buffer_type, use_flags>(text, sa, n, threads,
+                                           initial_sort_prefix_len, observer);
+  });
+}
+
+template<typename p1_sorter = MSD, typename p2_sorter = MSD,
+    typename buffer_type = auto_buffer_type,
+    bool use_flags = true,
+    typename index_type, // auto deduce
+    typename value_type>
+static gsaca_job
+gsaca_ds_async(value_type const *const text, index_type *const sa,
+               size_t const n, size_t const initial_sort_prefix_len = 1) {
+  return run_async([=](async_internal::progress_observer observer) {
+      gsaca_ds<p1_sorter, p2_sorter, buffer_type, use_flags>(
+          text, sa, n, initial_sort_prefix_len, observer);
+  });
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gsaca_lyndon {
+
+enum sorter_id : uint8_t {
+  sorter_id_msd = 0,
+  sorter_id_lsd = 1,
+  sorter_id_ips4o = 2,
+  sorter_id_count = 3
+};
+
+constexpr char const *sorter_id_names[sorter_id_count] = {
+    "msd", "lsd", "ips4o"};
+
+// The template parameters of gsaca_ds as runtime values. wide_buffer selects
+// the index type itself as buffer type instead of the auto buffer type; it
+// only makes a difference for index types wider than five bytes.
+struct gsaca_config {
+  uint8_t p1_sorter;
+  uint8_t p2_sorter;
+  bool use_flags;
+  bool wide_buffer;
+  uint8_t prefix;
+};
+
+// A profile maps inputs to configurations: the first entry with n <= max_n
+// and sigma <= max_sigma (number of distinct symbols) is used.
+struct gsaca_profile_entry {
+  size_t max_n;
+  size_t max_sigma;
+  gsaca_config config;
+};
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Configuration profile of gsaca_ds_auto, generated by
+// benchmark/autotune --emit-profile. The default is gsaca_ds1.
+
+#include "auto_config.hpp"
+
+namespace gsaca_lyndon {
+namespace auto_profile {
+
+constexpr char const *machine = "default";
+constexpr gsaca_profile_entry entries[] = {
+    {SIZE_MAX, SIZE_MAX, {sorter_id_msd, sorter_id_msd, true, false, 1}}};
+
+} // namespace auto_profile
+} // namespace gsaca_lyndon
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <omp.h>
+#include <cstdlib>
+#include <vector>
+#include "lcp.hpp"
+
+namespace gsaca_lyndon {
+
+// Compressed LCP arrays, following the conventions of lcp.hpp (both
+// sentinels are distinct symbols, plcp[0] = plcp[n - 1] = 0).
+//
+// succinct_plcp stores the PLCP array (text order) in 2n bits: plcp[i] + i
+// does not decrease, thus the i-th one of a bitvector is placed at position
+// plcp[i] + 2i. Every sample_rate-th position is sampled; plcp[i] is found
+// from the preceding sample by skipping ones. Decoding in text order only
+// needs the next one of the bitvector.
+//
+// dac_lcp stores the LCP array (suffix array order) as directly addressable
+// codes: the lowest byte of every value is stored on level 0, values with
+// more bytes are continued on the next level (marked by a bit, the rank of
+// the bit is the index on the next level). Decoding in suffix array order
+// keeps one index per level and needs no rank queries.
+namespace compressed_lcp_internal {
+
+// position of the k-th (0-based) one in the word
+inline static uint64_t select_in_word(uint64_t word, uint64_t k) {
+  for (; k > 0; --k) word &= word - 1;
+  return __builtin_ctzll(word);
+}
+
+// Ones before position i, one cumulative count per 512 bits.
+struct rank_support {
+  std::vector<uint64_t> blocks;
+
+  void build(std::vector<uint64_t> const &bits) {
+    blocks.assign((bits.size() >> 3) + 1, 0);
+    uint64_t count = 0;
+    for (size_t w = 0; w < bits.size(); ++w) {
+      if ((w & 7) == 0) blocks[w >> 3] = count;
+      count += __builtin_popcountll(bits[w]);
+    }
+  }
+
+  uint64_t rank(std::vector<uint64_t> const &bits, uint64_t const i) const {
+    uint64_t result = blocks[i >> 9];
+    for (uint64_t w = (i >> 9) << 3; w < (i >> 6); ++w) {
+      result += __builtin_popcountll(bits[w]);
+    }
+    uint64_t const mask = (1ULL << (i & 63)) - 1;
+    return result + __builtin_popcountll(bits[i >> 6] & mask);
+  }
+};
+
+}
+
+class succinct_plcp {
+public:
+  static constexpr uint64_t sample_rate = 256;
+
+  // Decodes plcp[i], plcp[i + 1], ... sequentially.
+  class iterator {
+  public:
+    iterator(succinct_plcp const *const plcp, uint64_t const i)
+        : plcp_(plcp), i_(i) {
+      if (i_ < plcp_->n_) {
+        position_ = plcp_->select(i_);
+        word_ = plcp_->bits_[position_ >> 6] & (~0ULL << (position_ & 63));
+      }
+    }
+
+    uint64_t operator*() const {
+      return position_ - 2 * i_;
+    }
+
+    iterator &operator++() {
+      if (++i_ < plcp_->n_) {
+        word_ &= word_ - 1;
+        uint64_t w = position_ >> 6;
+        while (word_ == 0) word_ = plcp_->bits_[++w];
+        position_ = (w << 6) + __builtin_ctzll(word_);
+      }
+      return *this;
+    }
+
+    bool operator==(iterator const &other) const {
+      return i_ == other.i_;
+    }
+
+    bool operator!=(iterator const &other) const {
+      return i_ != other.i_;
+    }
+
+  private:
+    succinct_plcp const *plcp_;
+    uint64_t i_;
+    uint64_t position_ = 0;
+    uint64_t word_ = 0;
+  };
+
+  size_t size() const {
+    return n_;
+  }
+
+  size_t bytes() const {
+    return (bits_.size() + samples_.size()) * sizeof(uint64_t);
+  }
+
+  uint64_t operator[](uint64_t const i) const {
+    return select(i) - 2 * i;
+  }
+
+  iterator begin(uint64_t const i = 0) const {
+    return iterator(this, i);
+  }
+
+  iterator end() const {
+    return iterator(this, n_);
+  }
+
+  // Ones at plcp[i] + 2i, computed in parallel from the plain PLCP array.
+  // Each thread writes the words that only it touches, the first and the
+  // last word of every thread are combined afterwards.
+  template<typename lcp_type>
+  void build(lcp_type const *const plcp, size_t const n,
+             size_t const threads = 1) {
+    n_ = n;
+    bits_.assign(((2 * n) >> 6) + 2, 0);
+    samples_.resize((n + sample_rate - 1) / sample_rate);
+    std::vector<uint64_t> edge_index(2 * threads, 0);
+    std::vector<uint64_t> edge_word(2 * threads, 0);
+
+    #pragma omp parallel for num_threads(threads)
+    for (size_t t = 0; t < threads; ++t) {
+      uint64_t const begin = n * t / threads;
+      uint64_t const end = n * (t + 1) / threads;
+      if (begin >= end) continue;
+      uint64_t const first = ((uint64_t) plcp[begin] + 2 * begin) >> 6;
+      uint64_t w = first;
+      uint64_t word = 0;
+      for (uint64_t i = begin; i < end; ++i) {
+        uint64_t const position = (uint64_t) plcp[i] + 2 * i;
+        if ((position >> 6) != w) {
+          if (w == first) edge_word[2 * t] = word;
+          else bits_[w] = word;
+          w = position >> 6;
+          word = 0;
+        }
+        word |= 1ULL << (position & 63);
+        if (i % sample_rate == 0) samples_[i / sample_rate] = position;
+      }
+      edge_index[2 * t] = first;
+      edge_index[2 * t + 1] = w;
+      if (w == first) edge_word[2 * t] = word;
+      else edge_word[2 * t + 1] = word;
+    }
+    for (size_t e = 0; e < 2 * threads; ++e) {
+      bits_[edge_index[e]] |= edge_word[e];
+    }
+  }
+
+private:
+  // position of the i-th one
+  uint64_t select(uint64_t const i) const {
+    uint64_t const position = samples_[i / sample_rate];
+    uint64_t k = i % sample_rate;
+    uint64_t w = position >> 6;
+    uint64_t word = bits_[w] & (~0ULL << (position & 63));
+    uint64_t ones = __builtin_popcountll(word);
+    while (ones <= k) {
+      k -= ones;
+      word = bits_[++w];
+      ones = __builtin_popcountll(word);
+    }
+    return (w << 6) + compressed_lcp_internal::select_in_word(word, k);
+  }
+
+  std::vector<uint64_t> bits_;
+  std::vector<uint64_t> samples_;
+  size_t n_ = 0;
+};
+
+class dac_lcp {
+  struct level {
+    std::vector<uint8_t> bytes;
+    std::vector<uint64_t> more; // value continues on the next level
+    compressed_lcp_internal::rank_support ranks;
+  };
+
+public:
+  static constexpr size_t max_levels = 8;
+
+  // Decodes lcp[k], lcp[k + 1], ... sequentially (k = 0 or the end).
+  class iterator {
+  public:
+    iterator(dac_lcp const *const lcp, uint64_t const k)
+        : lcp_(lcp), k_(k) {
+      if (k_ < lcp_->n_) decode();
+    }
+
+    uint64_t operator*() const {
+      return value_;
+    }
+
+    iterator &operator++() {
+      for (size_t l = 0; l < used_; ++l) ++index_[l];
+      if (++k_ < lcp_->n_) decode();
+      return *this;
+    }
+
+    bool operator==(iterator const &other) const {
+      return k_ == other.k_;
+    }
+
+    bool operator!=(iterator const &other) const {
+      return k_ != other.k_;
+    }
+
+  private:
+    void decode() {
+      value_ = 0;
+      used_ = 0;
+      auto const &levels = lcp_->levels_;
+      for (;;) {
+        uint64_t const j = index_[used_];
+        value_ |= ((uint64_t) levels[used_].bytes[j]) << (8 * used_);
+        bool const more = (levels[used_].more[j >> 6] >> (j & 63)) & 1;
+        ++used_;
+        if (!more) break;
+      }
+    }
+
+    dac_lcp const *lcp_;
+    uint64_t k_;
+    uint64_t index_[max_levels] = {};
+    uint64_t value_ = 0;
+    size_t used_ = 0;
+  };
+
+  size_t size() const {
+    return n_;
+  }
+
+  size_t bytes() const {
+    size_t result = 0;
+    for (auto const &l : levels_) {
+      result += l.bytes.size() + (l.more.size() + l.ranks.blocks.size()) *
+                                 sizeof(uint64_t);
+    }
+    return result;
+  }
+
+  uint64_t operator[](uint64_t k) const {
+    uint64_t value = 0;
+    for (size_t l = 0;; ++l) {
+      value |= ((uint64_t) levels_[l].bytes[k]) << (8 * l);
+      if (((levels_[l].more[k >> 6] >> (k & 63)) & 1) == 0) return value;
+      k = levels_[l].ranks.rank(levels_[l].more, k);
+    }
+  }
+
+  iterator begin() const {
+    return iterator(this, 0);
+  }
+
+  iterator end() const {
+    return iterator(this, n_);
+  }
+
+  // lcp[k] = plcp[sa[k]]. The first pass counts the values per thread and
+  // level, the second one writes them; on level 0 the threads own whole
+  // words of the bitvector, on the other levels the bits are set atomically.
+  template<typename index_type, typename lcp_type>
+  void build(index_type const *const sa, lcp_type const *const plcp,
+             size_t const n, size_t const threads = 1) {
+    n_ = n;
+    levels_.clear();
+    size_t const words = (n >> 6) + 1;
+    std::vector<uint64_t> counts(threads * max_levels, 0);
+    auto const bytes_of = [](uint64_t const value) {
+        size_t result = 1;
+        while (result < max_levels && (value >> (8 * result)) != 0) ++result;
+        return result;
+    };
+
+    #pragma omp parallel for num_threads(threads)
+    for (size_t t = 0; t < threads; ++t) {
+      uint64_t const begin = std::min((uint64_t) n, (words * t / threads) << 6);
+      uint64_t const end = std::min((uint64_t) n,
+                                    (words * (t + 1) / threads) << 6);
+      for (uint64_t k = begin; k < end; ++k) {
+        size_t const b = bytes_of(plcp[(uint64_t) sa[k]]);
+        for (size_t l = 0; l < b; ++l) ++counts[t * max_levels + l];
+      }
+    }
+
+    // counts become the first index of each thread on each level
+    for (size_t l = 0; l < max_levels; ++l) {
+      uint64_t total = 0;
+      for (size_t t = 0; t < threads; ++t) {
+        uint64_t const count = counts[t * max_levels + l];
+        counts[t * max_levels + l] = total;
+        total += count;
+      }
+      if (total == 0) break;
+      levels_.emplace_back();
+      levels_.back().bytes.resize(total);
+      levels_.back().more.assign((total >> 6) + 1, 0);
+    }
+
+    #pragma omp parallel for num_threads(threads)
+    for (size_t t = 0; t < threads; ++t) {
+      uint64_t const begin = std::min((uint64_t) n, (words * t / threads) << 6);
+      uint64_t const end = std::min((uint64_t) n,
+                                    (words * (t + 1) / threads) << 6);
+      uint64_t *const index = &counts[t * max_levels];
+      for (uint64_t k = begin; k < end; ++k) {
+        uint64_t const value = plcp[(uint64_t) sa[k]];
+        size_t const b = bytes_of(value);
+        for (size_t l = 0; l < b; ++l) {
+          uint64_t const j = index[l]++;
+          levels_[l].bytes[j] = value >> (8 * l);
+          if (l + 1 == b) continue;
+          uint64_t const bit = 1ULL << (j & 63);
+          if (l == 0) levels_[l].more[j >> 6] |= bit;
+          else __atomic_fetch_or(&levels_[l].more[j >> 6], bit,
+                                 __ATOMIC_RELAXED);
+        }
+      }
+    }
+    for (auto &l : levels_) l.ranks.build(l.more);
+  }
+
+private:
+  std::vector<level> levels_;
+  size_t n_ = 0;
+};
+
+// Builds the succinct PLCP array and optionally the DAC encoded LCP array
+// from the text and its suffix array. The plain PLCP array is computed in
+// scratch (n entries), e.g. in the isa buffer of phases::phase_2, whose
+// content is not needed after it returns.
+template<typename index_type, typename value_type, typename lcp_type>
+static void compressed_lcp(value_type const *const text,
+                           index_type const *const sa, size_t const n,
+                           lcp_type *const scratch, succinct_plcp &plcp,
+                           dac_lcp *const lcp = nullptr,
+                           size_t const threads = 1) {
+  plcp_by_phi_parallel(text, sa, scratch, n, threads);
+  plcp.build(scratch, n, threads);
+  if (lcp != nullptr) lcp->build(sa, scratch, n, threads);
+}
+
+// As above with an allocated scratch array; false if it cannot be allocated.
+template<typename index_type, typename value_type>
+static bool compressed_lcp(value_type const *const text,
+                           index_type const *const sa, size_t const n,
+                           succinct_plcp &plcp, dac_lcp *const lcp = nullptr,
+                           size_t const threads = 1) {
+  using lcp_type = std::conditional_t<std::is_unsigned<index_type>::value,
+      index_type, uint64_t>;
+  lcp_type *const scratch = (lcp_type *) malloc(n * sizeof(lcp_type));
+  if (scratch == nullptr) return false;
+  compressed_lcp(text, sa, n, scratch, plcp, lcp, threads);
+  free(scratch);
+  return true;
+}
+
+}
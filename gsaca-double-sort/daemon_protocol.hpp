@@ -0,0 +1,215 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+
+namespace gsaca_lyndon {
+
+// Protocol of the local suffix sorting daemon (tools/gsaca-daemon.cpp).
+//
+// A client connects to the daemon's Unix domain socket and sends exactly one
+// daemon_request. Sort requests carry two file descriptors (SCM_RIGHTS): the
+// text (n bytes including both sentinels) and the output suffix array
+// (n * index_bytes bytes), usually both created with memfd_create. The daemon
+// maps both and writes the suffix array in place, i.e. no data is copied.
+// Once the job is finished (or rejected), the daemon replies with a
+// daemon_response. Stats requests are answered with daemon_stats.
+//
+// The daemon is shared, so it does not trust the descriptors: the text must
+// be sealed against shrinking and writing, the suffix array against
+// shrinking (see seal_shared_text and seal_shared_output), otherwise the
+// request is rejected with status_not_sealed. The text has to follow the
+// conventions of gsaca_ds (text[0] = text[n - 1] = 0, no other zeros, else
+// status_bad_text), and n has to fit the index width (n < 2^32 for 4 bytes,
+// n < 2^40 for 5 bytes).
+namespace daemon_protocol {
+
+constexpr uint32_t magic = 0x47534431; // "GSD1"
+
+enum request_type : uint32_t {
+  request_sort = 1,
+  request_stats = 2
+};
+
+enum response_status : int32_t {
+  status_ok = 0,
+  status_bad_request = 1,
+  status_map_failed = 2,
+  status_shutting_down = 3,
+  status_not_sealed = 4,
+  status_bad_text = 5
+};
+
+// seals required on the descriptors of a sort request
+constexpr int text_seals = F_SEAL_SHRINK | F_SEAL_WRITE;
+constexpr int output_seals = F_SEAL_SHRINK;
+
+} // namespace daemon_protocol
+
+struct daemon_request {
+  uint32_t magic;
+  uint32_t type;
+  uint64_t n;
+  uint32_t index_bytes; // 4, 5 or 8
+  int32_t priority; // higher is more urgent
+};
+
+struct daemon_response {
+  int32_t status;
+  uint32_t reserved;
+  uint64_t queue_ns; // time between submission and start
+  uint64_t run_ns;
+};
+
+struct daemon_stats {
+  uint64_t jobs_completed;
+  uint64_t jobs_failed;
+  uint64_t queued_small;
+  uint64_t queued_big;
+  uint64_t running;
+  uint64_t total_queue_ns;
+  uint64_t max_queue_ns;
+  uint64_t total_run_ns;
+  uint64_t max_run_ns;
+  uint64_t total_bytes_sorted;
+};
+
+namespace daemon_internal {
+
+inline int connect_to(char const *const socket_path) {
+  int const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+  if (connect(fd, (sockaddr *) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// sends a message, optionally with file descriptors attached
+inline bool send_message(int const socket, void const *const data,
+                         size_t const bytes, int const *const fds = nullptr,
+                         size_t const fd_count = 0) {
+  iovec iov = {(void *) data, bytes};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+  if (fd_count > 0) {
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(fd_count * sizeof(int));
+    cmsghdr *const cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fd_count * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, fd_count * sizeof(int));
+  }
+  return sendmsg(socket, &msg, MSG_NOSIGNAL) == (ssize_t) bytes;
+}
+
+// receives a message of exactly the given size, and up to two descriptors
+inline bool receive_message(int const socket, void *const data,
+                            size_t const bytes, int *const fds = nullptr,
+                            size_t *const fd_count = nullptr) {
+  iovec iov = {data, bytes};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  if (recvmsg(socket, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC) !=
+      (ssize_t) bytes) {
+    return false;
+  }
+  if (fd_count != nullptr) {
+    *fd_count = 0;
+    cmsghdr *const cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_RIGHTS) {
+      *fd_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      memcpy(fds, CMSG_DATA(cmsg), *fd_count * sizeof(int));
+    }
+  }
+  return true;
+}
+
+} // namespace daemon_internal
+
+// Submits a suffix sorting job and blocks until the daemon has finished it.
+// The descriptors stay owned by the caller.
+inline bool daemon_submit(char const *const socket_path, int const text_fd,
+                          int const sa_fd, uint64_t const n,
+                          uint32_t const index_bytes, int32_t const priority,
+                          daemon_response &response) {
+  int const socket = daemon_internal::connect_to(socket_path);
+  if (socket < 0) return false;
+  daemon_request const request = {daemon_protocol::magic,
+                                  daemon_protocol::request_sort, n,
+                                  index_bytes, priority};
+  int const fds[2] = {text_fd, sa_fd};
+  bool const ok =
+      daemon_internal::send_message(socket, &request, sizeof(request), fds,
+                                    2) &&
+      daemon_internal::receive_message(socket, &response, sizeof(response));
+  close(socket);
+  return ok;
+}
+
+inline bool daemon_query_stats(char const *const socket_path,
+                               daemon_stats &stats) {
+  int const socket = daemon_internal::connect_to(socket_path);
+  if (socket < 0) return false;
+  daemon_request const request = {daemon_protocol::magic,
+                                  daemon_protocol::request_stats, 0, 0, 0};
+  bool const ok =
+      daemon_internal::send_message(socket, &request, sizeof(request)) &&
+      daemon_internal::receive_message(socket, &stats, sizeof(stats));
+  close(socket);
+  return ok;
+}
+
+// Creates an anonymous shared memory file of the given size and maps it.
+inline int create_shared_buffer(char const *const name, size_t const bytes,
+                                void **const mapping) {
+  int const fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) return -1;
+  if (ftruncate(fd, bytes) != 0) {
+    close(fd);
+    return -1;
+  }
+  *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (*mapping == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Seals a text buffer once it has been written. Writing can only be sealed
+// without writable mappings, thus the mapping is replaced by a read-only one.
+inline bool seal_shared_text(int const fd, size_t const bytes,
+                             void **const mapping) {
+  munmap(*mapping, bytes);
+  *mapping = MAP_FAILED;
+  if (fcntl(fd, F_ADD_SEALS, daemon_protocol::text_seals) != 0) return false;
+  *mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  return *mapping != MAP_FAILED;
+}
+
+// Seals an output buffer; it stays writable, but cannot shrink.
+inline bool seal_shared_output(int const fd) {
+  return fcntl(fd, F_ADD_SEALS, daemon_protocol::output_seals) == 0;
+}
+
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include "lcp.hpp"
+#include "parallel/gsaca-ds-par.hpp"
+
+namespace gsaca_lyndon {
+
+// A duplicated text range [begin, end) (text positions including the leading
+// sentinel) within the given document. Documents are numbered from 0 in text
+// order and are separated by the separator symbol.
+struct duplicate_range {
+  uint64_t document;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// Finds all substrings of length at least min_length that occur more than
+// once in the text. Of all occurrences of such a substring, the leftmost one
+// is kept and all others are reported as duplicates. Occurrences never cross
+// document boundaries. The reported ranges are sorted, maximal (i.e. merged
+// per document) and non-overlapping.
+//
+// The LCP values are computed in text order (PLCP) and consumed directly in
+// suffix array order, no LCP array is materialized.
+template<typename index_type, typename value_type>
+static std::vector<duplicate_range>
+find_duplicates_par(value_type const *const text, index_type const *const sa,
+                    size_t const n, size_t const min_length,
+                    value_type const separator, size_t const threads = 0) {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+
+  size_t const p = (threads == 0) ? omp_get_max_threads() : threads;
+  size_t const L = std::max(min_length, (size_t) 1);
+
+  index_type *const plcp = (index_type *) malloc(n * sizeof(index_type));
+  plcp_by_phi_parallel(text, sa, plcp, n, p, separator);
+  auto lcp = [&](size_t const i) -> size_t {
+      return plcp[(uint64_t) sa[i]];
+  };
+
+  // mark the starting positions of all non-leftmost occurrences
+  std::vector<uint64_t> starts((n + 63) >> 6);
+  uint64_t *const start_bits = starts.data();
+
+  #pragma omp parallel for num_threads(p)
+  for (size_t t = 0; t < p; ++t) {
+    size_t const chunk = n / p + (n % p > 0);
+    size_t const end = std::min(n, (t + 1) * chunk);
+    size_t i = std::max(t * chunk, (size_t) 1);
+
+    // skip the run that started in the previous chunk
+    while (i < end && lcp(i) >= L) ++i;
+
+    while (i < end) {
+      size_t run_end = i;
+      uint64_t leftmost = sa[i];
+      while (run_end + 1 < n && lcp(run_end + 1) >= L) {
+        leftmost = std::min(leftmost, (uint64_t) sa[++run_end]);
+      }
+      if (run_end > i) {
+        for (size_t j = i; j <= run_end; ++j) {
+          uint64_t const pos = sa[j];
+          if (pos != leftmost) {
+            __atomic_fetch_or(&(start_bits[pos >> 6]), 1ULL << (pos & 63),
+                              __ATOMIC_RELAXED);
+          }
+        }
+      }
+      i = run_end + 1;
+    }
+  }
+  free(plcp);
+
+  // each occurrence covers L symbols, merge them into maximal ranges
+  std::vector<std::vector<duplicate_range>> chunk_ranges(p);
+  std::vector<uint64_t> chunk_documents(p + 1);
+
+  #pragma omp parallel for num_threads(p)
+  for (size_t t = 0; t < p; ++t) {
+    size_t const chunk = n / p + (n % p > 0);
+    size_t const begin = std::min(n, t * chunk);
+    size_t const end = std::min(n, (t + 1) * chunk);
+    uint64_t separators = 0;
+    for (size_t i = begin; i < end; ++i) {
+      separators += (text[i] == separator);
+    }
+    chunk_documents[t + 1] = separators;
+  }
+  for (size_t t = 0; t < p; ++t) {
+    chunk_documents[t + 1] += chunk_documents[t];
+  }
+
+  #pragma omp parallel for num_threads(p)
+  for (size_t t = 0; t < p; ++t) {
+    size_t const chunk = n / p + (n % p > 0);
+    size_t const begin = std::min(n, t * chunk);
+    size_t const end = std::min(n, (t + 1) * chunk);
+    uint64_t document = chunk_documents[t];
+    auto &ranges = chunk_ranges[t];
+
+    for (size_t i = begin; i < end; ++i) {
+      document += (text[i] == separator);
+      if ((start_bits[i >> 6] >> (i & 63)) & 1) {
+        if (!ranges.empty() && ranges.back().end >= i) {
+          ranges.back().end = i + L;
+        } else {
+          ranges.emplace_back(duplicate_range{document, i, i + L});
+        }
+      }
+    }
+  }
+
+  std::vector<duplicate_range> result;
+  for (auto const &ranges : chunk_ranges) {
+    for (auto const &range : ranges) {
+      if (!result.empty() && result.back().end >= range.begin) {
+        result.back().end = std::max(result.back().end, range.end);
+      } else {
+        result.push_back(range);
+      }
+    }
+  }
+  return result;
+}
+
+// Builds the suffix array with gsaca_ds2_par and reports all duplicates.
+template<typename index_type = uint40_t, typename value_type>
+static std::vector<duplicate_range>
+dedup_par(value_type const *const text, size_t const n,
+          size_t const min_length, value_type const separator,
+          size_t const threads = 0) {
+  index_type *const sa = (index_type *) malloc(n * sizeof(index_type));
+  gsaca_ds2_par(text, sa, n, threads);
+  auto result = find_duplicates_par(text, sa, n, min_length, separator,
+                                    threads);
+  free(sa);
+  return result;
+}
+
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "sequential/gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+// Delta suffix sorting: computes the suffix array of a new text from the
+// suffix array and inverse suffix array of a similar old text. Both texts use
+// the usual sentinels. The alignment consists of blocks, each mapping
+// new_text[new_begin, new_begin + length) to old_text[old_begin, ...);
+// positions inside a block may still differ (substitutions).
+//
+// A new suffix is clean if it is aligned (mapped and equal to its old
+// counterpart) for more than L symbols, where L is the longest common prefix
+// of its old suffix with its neighbors in the old suffix array. The old
+// order of two clean suffixes is decided within the aligned symbols, thus
+// clean suffixes keep their relative order. L decreases by at most one from
+// one position to the next, so the dirty suffixes in front of an edit are
+// found by walking backwards until the first clean one. Dirty suffixes are
+// sorted by comparing symbols until both sides are clean (then the old ranks
+// decide) and merged into the clean ones by binary search.
+struct delta_block {
+  uint64_t new_begin;
+  uint64_t old_begin;
+  uint64_t length;
+};
+
+// Alignment without a diff: equal lengths are aligned position by position,
+// otherwise the common prefix and the common suffix are aligned.
+template<typename value_type>
+static std::vector<delta_block>
+delta_alignment(value_type const *const old_text, size_t const old_n,
+                value_type const *const new_text, size_t const new_n) {
+  if (old_n == new_n) return {delta_block{0, 0, new_n}};
+  size_t const max = std::min(old_n, new_n);
+  size_t prefix = 0;
+  while (prefix < max && old_text[prefix] == new_text[prefix]) ++prefix;
+  size_t suffix = 0;
+  while (suffix < max - prefix &&
+         old_text[old_n - 1 - suffix] == new_text[new_n - 1 - suffix]) {
+    ++suffix;
+  }
+  return {delta_block{0, 0, prefix},
+          delta_block{new_n - suffix, old_n - suffix, suffix}};
+}
+
+namespace delta_internal {
+
+// at most this fraction of dirty suffixes, otherwise gsaca_ds is used (each
+// dirty suffix costs a search with random accesses, on 2^24 random DNA
+// symbols the break-even is at about 1.5% dirty suffixes)
+constexpr size_t max_dirty_divisor = 64;
+
+template<typename value_type>
+static uint64_t lcp(value_type const *const text, size_t const n,
+                    uint64_t const a, uint64_t const b) {
+  uint64_t l = 0;
+  while (a + l < n - 1 && b + l < n - 1 && text[a + l] == text[b + l]) ++l;
+  return l;
+}
+
+}
+
+// Writes the suffix array (and, if new_isa is not null, the inverse suffix
+// array) of new_text. Returns false if the texts were too different and the
+// suffix array was computed from scratch by gsaca_ds instead.
+template<typename index_type, typename value_type>
+static bool delta_gsaca_ds(value_type const *const old_text,
+                           index_type const *const old_sa,
+                           index_type const *const old_isa,
+                           size_t const old_n,
+                           value_type const *const new_text,
+                           index_type *const new_sa, size_t const new_n,
+                           std::vector<delta_block> const &alignment,
+                           index_type *const new_isa = nullptr) {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+  size_t const max_dirty = new_n / delta_internal::max_dirty_divisor;
+
+  auto const from_scratch = [&]() {
+      gsaca_ds(new_text, new_sa, new_n, 2);
+      if (new_isa != nullptr) {
+        for (size_t i = 0; i < new_n; ++i) new_isa[(uint64_t) new_sa[i]] = i;
+      }
+      return false;
+  };
+  if (new_n < 16 || old_n < 16) return from_scratch();
+
+  // blocks must not overlap, neither in the new nor in the old text
+  std::vector<delta_block> by_old = alignment;
+  std::vector<delta_block> by_new = alignment;
+  std::sort(by_old.begin(), by_old.end(),
+            [](delta_block const &a, delta_block const &b) {
+                return a.old_begin < b.old_begin;
+            });
+  std::sort(by_new.begin(), by_new.end(),
+            [](delta_block const &a, delta_block const &b) {
+                return a.new_begin < b.new_begin;
+            });
+  for (size_t i = 0; i < alignment.size(); ++i) {
+    if (by_old[i].old_begin + by_old[i].length > old_n ||
+        by_new[i].new_begin + by_new[i].length > new_n ||
+        (i > 0 && (by_old[i - 1].old_begin + by_old[i - 1].length >
+                   by_old[i].old_begin ||
+                   by_new[i - 1].new_begin + by_new[i - 1].length >
+                   by_new[i].new_begin))) {
+      return from_scratch();
+    }
+  }
+
+  // old position of every aligned interior new position, 0 if not aligned
+  std::vector<index_type> old_pos(new_n, 0);
+  for (auto const &block : alignment) {
+    for (uint64_t i = 0; i < block.length; ++i) {
+      uint64_t const p = block.new_begin + i;
+      uint64_t const x = block.old_begin + i;
+      if (p > 0 && p < new_n - 1 && x > 0 && x < old_n - 1 &&
+          new_text[p] == old_text[x]) {
+        old_pos[p] = x;
+      }
+    }
+  }
+
+  // Walk over the maximal runs [b, e) of aligned positions from right to
+  // left. The suffixes of a run that reaches the final sentinel are
+  // identical to their old counterparts.
+  std::vector<bool> dirty(new_n, false);
+  std::vector<uint64_t> dirty_list;
+  for (uint64_t e = new_n - 1; e > 1;) {
+    if (old_pos[e - 1] == 0) {
+      dirty[e - 1] = true;
+      dirty_list.push_back(e - 1);
+      --e;
+      continue;
+    }
+    uint64_t b = e - 1;
+    while (b > 1 && old_pos[b - 1] != 0 &&
+           (uint64_t) old_pos[b - 1] + 1 == (uint64_t) old_pos[b]) {
+      --b;
+    }
+    bool const to_end = (e == new_n - 1) &&
+                        ((uint64_t) old_pos[e - 1] == old_n - 2);
+    for (uint64_t q = e; !to_end && q-- > b;) {
+      uint64_t const x = old_pos[q];
+      uint64_t const rank = old_isa[x];
+      uint64_t l = delta_internal::lcp(old_text, old_n, x, old_sa[rank - 1]);
+      if (rank + 1 < old_n) {
+        l = std::max(l, delta_internal::lcp(old_text, old_n, x,
+                                            old_sa[rank + 1]));
+      }
+      if (l < e - q) break;
+      dirty[q] = true;
+      dirty_list.push_back(q);
+    }
+    if (dirty_list.size() > max_dirty) return from_scratch();
+    e = b;
+  }
+
+  auto const clean = [&](uint64_t const p) {
+      return p > 0 && p < new_n - 1 && !dirty[p];
+  };
+  auto const less = [&](uint64_t const a, uint64_t const b) {
+      for (uint64_t k = 0;; ++k) {
+        uint64_t const p = a + k;
+        uint64_t const q = b + k;
+        if (clean(p) && clean(q)) {
+          return (uint64_t) old_isa[(uint64_t) old_pos[p]] <
+                 (uint64_t) old_isa[(uint64_t) old_pos[q]];
+        }
+        if (new_text[p] != new_text[q]) return new_text[p] < new_text[q];
+      }
+  };
+
+  // clean suffixes in old order, at the end of new_sa; the old positions of
+  // clean suffixes are marked in a bit vector to keep the scan cache friendly
+  std::vector<bool> clean_old(old_n, false);
+  for (uint64_t p = 1; p < new_n - 1; ++p) {
+    if (!dirty[p]) clean_old[(uint64_t) old_pos[p]] = true;
+  }
+  // dirty suffixes with an old counterpart, by old rank (hint for the merge)
+  std::vector<std::pair<uint64_t, size_t>> by_rank;
+  for (size_t d = 0; d < dirty_list.size(); ++d) {
+    uint64_t const x = old_pos[dirty_list[d]];
+    if (x != 0) by_rank.emplace_back(old_isa[x], d);
+  }
+  std::sort(by_rank.begin(), by_rank.end());
+  std::vector<size_t> hint(dirty_list.size(), SIZE_MAX);
+
+  size_t const first_clean = 2 + dirty_list.size();
+  size_t out = first_clean;
+  size_t next_hint = 0;
+  auto block = by_old.begin();
+  for (size_t r = 0; r < old_n; ++r) {
+    while (next_hint < by_rank.size() && by_rank[next_hint].first == r) {
+      hint[by_rank[next_hint++].second] = out;
+    }
+    uint64_t const x = old_sa[r];
+    if (!clean_old[x]) continue;
+    if (x < block->old_begin || x >= block->old_begin + block->length) {
+      block = std::upper_bound(by_old.begin(), by_old.end(), x,
+                               [](uint64_t const v, delta_block const &b) {
+                                   return v < b.old_begin;
+                               }) - 1;
+    }
+    new_sa[out++] = block->new_begin + (x - block->old_begin);
+  }
+
+  // insertion point of every dirty suffix among the clean ones, by galloping
+  // from its old rank
+  std::vector<std::pair<size_t, uint64_t>> insert(dirty_list.size());
+  for (size_t d = 0; d < dirty_list.size(); ++d) {
+    uint64_t const suffix = dirty_list[d];
+    size_t lo = first_clean, hi = new_n;
+    if (hint[d] != SIZE_MAX) {
+      size_t const h = hint[d];
+      size_t step = 1;
+      if (h < new_n && less(new_sa[h], suffix)) {
+        lo = h + 1;
+        while (lo + step < new_n && less(new_sa[lo + step - 1], suffix)) {
+          lo += step;
+          step *= 2;
+        }
+        hi = std::min(new_n, lo + step);
+      } else {
+        hi = h;
+        while (hi > first_clean + step && !less(new_sa[hi - step], suffix)) {
+          hi -= step;
+          step *= 2;
+        }
+        lo = (hi > first_clean + step) ? hi - step : first_clean;
+      }
+    }
+    while (lo < hi) {
+      size_t const mid = (lo + hi) / 2;
+      if (less(suffix, new_sa[mid])) hi = mid;
+      else lo = mid + 1;
+    }
+    insert[d] = {lo, suffix};
+  }
+  // dirty suffixes between the same clean ones are few, compare them directly
+  std::sort(insert.begin(), insert.end(),
+            [&](std::pair<size_t, uint64_t> const &a,
+                std::pair<size_t, uint64_t> const &b) {
+                return (a.first != b.first) ? a.first < b.first
+                                            : less(a.second, b.second);
+            });
+
+  // merge, the output never overtakes the clean suffixes still to be read
+  new_sa[0] = new_n - 1;
+  new_sa[1] = 0;
+  size_t write = 2, read = first_clean;
+  for (auto const &entry : insert) {
+    while (read < entry.first) new_sa[write++] = new_sa[read++];
+    new_sa[write++] = entry.second;
+  }
+
+  if (new_isa != nullptr) {
+    for (size_t i = 0; i < new_n; ++i) new_isa[(uint64_t) new_sa[i]] = i;
+  }
+  return true;
+}
+
+template<typename index_type, typename value_type>
+static bool delta_gsaca_ds(value_type const *const old_text,
+                           index_type const *const old_sa,
+                           index_type const *const old_isa,
+                           size_t const old_n,
+                           value_type const *const new_text,
+                           index_type *const new_sa, size_t const new_n,
+                           index_type *const new_isa = nullptr) {
+  return delta_gsaca_ds(old_text, old_sa, old_isa, old_n, new_text, new_sa,
+                        new_n, delta_alignment(old_text, old_n, new_text,
+                                               new_n), new_isa);
+}
+
+}
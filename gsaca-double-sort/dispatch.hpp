@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdlib>
+#include <utility>
+#include "sequential/gsaca-ds.hpp"
+#include "parallel/gsaca-ds-par.hpp"
+
+namespace gsaca_lyndon {
+
+// Suffix arrays whose entry width is chosen at runtime from the text length.
+// The engines are instantiated for uint32_t, uint40_t and uint64_t entries;
+// gsaca_ds_any picks the instantiation and returns the suffix array together
+// with its width, so callers do not need one code path per index type.
+enum class index_width_policy : uint32_t {
+  smallest = 0, // 4, 5 or 8 bytes per entry
+  aligned = 1,  // 4 or 8 bytes per entry (no five-byte entries)
+  wide = 2      // always 8 bytes per entry
+};
+
+// Bytes per entry that suffice for a text of length n (entries are < n).
+static size_t select_index_width(size_t const n,
+                                 index_width_policy const policy) {
+  if (policy != index_width_policy::wide && ((uint64_t) n >> 32) == 0) {
+    return 4;
+  }
+  if (policy == index_width_policy::smallest && ((uint64_t) n >> 40) == 0) {
+    return 5;
+  }
+  return 8;
+}
+
+// Owns a suffix array of n entries of width() bytes each.
+class any_suffix_array {
+public:
+  any_suffix_array() = default;
+
+  any_suffix_array(size_t const n, size_t const width) {
+    if (width != 4 && width != 5 && width != 8) return;
+    data_ = malloc(n * width);
+    if (data_ != nullptr) {
+      n_ = n;
+      width_ = width;
+    }
+  }
+
+  any_suffix_array(any_suffix_array const &) = delete;
+
+  any_suffix_array &operator=(any_suffix_array const &) = delete;
+
+  any_suffix_array(any_suffix_array &&other) noexcept {
+    *this = std::move(other);
+  }
+
+  any_suffix_array &operator=(any_suffix_array &&other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(n_, other.n_);
+    std::swap(width_, other.width_);
+    return *this;
+  }
+
+  ~any_suffix_array() {
+    free(data_);
+  }
+
+  explicit operator bool() const {
+    return data_ != nullptr;
+  }
+
+  size_t size() const {
+    return n_;
+  }
+
+  // bytes per entry: 4, 5 or 8
+  size_t width() const {
+    return width_;
+  }
+
+  void const *data() const {
+    return data_;
+  }
+
+  uint64_t operator[](size_t const i) const {
+    switch (width_) {
+      case 4:
+        return ((uint32_t const *) data_)[i];
+      case 5:
+        return ((uint40_t const *) data_)[i];
+      default:
+        return ((uint64_t const *) data_)[i];
+    }
+  }
+
+  // Calls function with the entries as a typed pointer (uint32_t, uint40_t
+  // or uint64_t), e.g. to run code instantiated for the actual width.
+  template<typename function_type>
+  decltype(auto) visit(function_type function) {
+    switch (width_) {
+      case 4:
+        return function((uint32_t *) data_);
+      case 5:
+        return function((uint40_t *) data_);
+      default:
+        return function((uint64_t *) data_);
+    }
+  }
+
+  template<typename function_type>
+  decltype(auto) visit(function_type function) const {
+    switch (width_) {
+      case 4:
+        return function((uint32_t const *) data_);
+      case 5:
+        return function((uint40_t const *) data_);
+      default:
+        return function((uint64_t const *) data_);
+    }
+  }
+
+private:
+  void *data_ = nullptr;
+  size_t n_ = 0;
+  size_t width_ = 0;
+};
+
+// Computes the suffix array with the smallest width allowed by the policy,
+// with gsaca_ds (threads = 1) or gsaca_ds_par (threads = 0: all threads).
+// The result is empty (false) if the memory could not be allocated.
+template<typename value_type>
+static any_suffix_array
+gsaca_ds_any(value_type const *const text, size_t const n,
+             index_width_policy const policy = index_width_policy::smallest,
+             size_t const threads = 1) {
+  any_suffix_array result(n, select_index_width(n, policy));
+  if (result) {
+    result.visit([&](auto *const sa) {
+        if (threads == 1) gsaca_ds(text, sa, n);
+        else gsaca_ds_par(text, sa, n, threads);
+    });
+  }
+  return result;
+}
+
+}
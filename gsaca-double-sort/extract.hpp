@@ -10,7 +10,7 @@ extract(value_type const *const text, count_type const &idx,
         uint8_t const count) {
   uint128_t result = text[idx];
   for (count_type i = 1; i < count; ++i) {
-    result <<= 8;
+    result <<= (sizeof(value_type) * 8);
     result |= text[idx + i];
   }
   return result;
@@ -27,8 +27,8 @@ safe_extract(value_type const *const text, count_type const &idx,
     result <<= (sizeof(value_type)*8);
     result |= text[idx + i];
   }
-  uint8_t const shift = sizeof(value_type) == 1 ? 3 : 5;
-  return result << ((count - i) << shift);
+  // missing symbols count as zeros
+  return result << ((count - i) * sizeof(value_type) * 8);
 }
 
 }
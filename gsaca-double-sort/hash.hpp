@@ -0,0 +1,161 @@
+#pragma once
+
+#include <omp.h>
+#include <cstring>
+#include <vector>
+#include "uint_types.hpp"
+
+namespace gsaca_lyndon {
+
+namespace hash_internal {
+
+constexpr uint64_t prime_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t prime_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t prime_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t prime_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t prime_5 = 0x27D4EB2F165667C5ULL;
+
+gsaca_always_inline uint64_t rotl(uint64_t const x, int const r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+gsaca_always_inline uint64_t read64(uint8_t const *const p) {
+  uint64_t result;
+  memcpy(&result, p, 8);
+  return result;
+}
+
+gsaca_always_inline uint64_t hash_round(uint64_t acc, uint64_t const lane) {
+  acc += lane * prime_2;
+  return rotl(acc, 31) * prime_1;
+}
+
+gsaca_always_inline uint64_t merge_round(uint64_t acc, uint64_t const val) {
+  acc ^= hash_round(0, val);
+  return acc * prime_1 + prime_4;
+}
+
+gsaca_always_inline uint64_t avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= prime_2;
+  h ^= h >> 29;
+  h *= prime_3;
+  h ^= h >> 32;
+  return h;
+}
+
+} // namespace hash_internal
+
+// 64-bit hash in the style of xxHash64: four independent accumulator lanes
+// over 32-byte stripes (which the compiler vectorizes), followed by a merge
+// of the lanes and the tail.
+inline uint64_t hash_bytes(void const *const data, size_t const bytes,
+                           uint64_t const seed = 0) {
+  using namespace hash_internal;
+  uint8_t const *p = (uint8_t const *) data;
+  uint8_t const *const end = p + bytes;
+  uint64_t h;
+
+  if (bytes >= 32) {
+    uint64_t acc[4] = {seed + prime_1 + prime_2, seed + prime_2, seed,
+                       seed - prime_1};
+    uint8_t const *const limit = end - 32;
+    do {
+      for (int lane = 0; lane < 4; ++lane) {
+        acc[lane] = hash_round(acc[lane], read64(p + 8 * lane));
+      }
+      p += 32;
+    } while (p <= limit);
+
+    h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) +
+        rotl(acc[3], 18);
+    for (int lane = 0; lane < 4; ++lane) {
+      h = merge_round(h, acc[lane]);
+    }
+  } else {
+    h = seed + prime_5;
+  }
+
+  h += bytes;
+  for (; p + 8 <= end; p += 8) {
+    h ^= hash_round(0, read64(p));
+    h = rotl(h, 27) * prime_1 + prime_4;
+  }
+  for (; p < end; ++p) {
+    h ^= (*p) * prime_5;
+    h = rotl(h, 11) * prime_1;
+  }
+  return avalanche(h);
+}
+
+// Fingerprints are hashes over fixed-size blocks that are combined in order.
+// Thus the fingerprint of a buffer does not depend on the number of threads,
+// and it can be computed incrementally while the buffer is being filled.
+constexpr size_t fingerprint_block_bytes = 1ULL << 20;
+
+inline uint64_t combine_block_hashes(uint64_t const *const block_hashes,
+                                     size_t const blocks, size_t const bytes) {
+  return hash_bytes(block_hashes, blocks * sizeof(uint64_t), bytes);
+}
+
+inline uint64_t fingerprint_parallel(void const *const data,
+                                     size_t const bytes,
+                                     size_t const threads = 0) {
+  size_t const p = (threads == 0) ? omp_get_max_threads() : threads;
+  size_t const blocks = (bytes + fingerprint_block_bytes - 1) /
+                        fingerprint_block_bytes;
+  std::vector<uint64_t> block_hashes(blocks);
+  uint8_t const *const bytes_ptr = (uint8_t const *) data;
+
+  #pragma omp parallel for num_threads(p) schedule(dynamic, 16)
+  for (size_t b = 0; b < blocks; ++b) {
+    size_t const begin = b * fingerprint_block_bytes;
+    size_t const len = std::min(fingerprint_block_bytes, bytes - begin);
+    block_hashes[b] = hash_bytes(bytes_ptr + begin, len);
+  }
+  return combine_block_hashes(block_hashes.data(), blocks, bytes);
+}
+
+// Computes the fingerprint of a buffer of known size that becomes available
+// from left to right, e.g. the suffix array during phase 2. Call update with
+// the number of bytes that are final, and finish once everything is final.
+class streaming_fingerprint {
+public:
+  streaming_fingerprint(void const *const data, size_t const bytes)
+      : data_((uint8_t const *) data), bytes_(bytes) {
+    block_hashes_.reserve((bytes + fingerprint_block_bytes - 1) /
+                          fingerprint_block_bytes);
+  }
+
+  gsaca_always_inline void update(size_t const final_bytes) {
+    if (gsaca_unlikely(final_bytes >= hashed_ + fingerprint_block_bytes)) {
+      hash_blocks(final_bytes);
+    }
+  }
+
+  uint64_t finish() {
+    hash_blocks(bytes_);
+    if (hashed_ < bytes_) {
+      block_hashes_.push_back(hash_bytes(data_ + hashed_, bytes_ - hashed_));
+      hashed_ = bytes_;
+    }
+    return combine_block_hashes(block_hashes_.data(), block_hashes_.size(),
+                                bytes_);
+  }
+
+private:
+  void hash_blocks(size_t const final_bytes) {
+    while (hashed_ + fingerprint_block_bytes <= final_bytes) {
+      block_hashes_.push_back(
+          hash_bytes(data_ + hashed_, fingerprint_block_bytes));
+      hashed_ += fingerprint_block_bytes;
+    }
+  }
+
+  uint8_t const *data_;
+  size_t bytes_;
+  size_t hashed_ = 0;
+  std::vector<uint64_t> block_hashes_;
+};
+
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "hash.hpp"
+#include "lcp.hpp"
+#include "parallel/gsaca-ds-par.hpp"
+#include "verify.hpp"
+
+namespace gsaca_lyndon {
+
+// Versioned container for a suffix array and derived arrays. The file starts
+// with an index_file_header, followed by the sections. Each section starts at
+// a page-aligned offset, such that a mapped file can be used in place. All
+// values are stored in native (little-endian) byte order, and the checksum of
+// a section is its fingerprint (see hash.hpp).
+enum index_section : uint32_t {
+  section_sa = 0,
+  section_isa = 1,
+  section_lcp = 2,
+  section_bwt = 3,
+  section_count = 4
+};
+
+struct index_section_entry {
+  uint64_t offset; // 0 if the section is not present
+  uint64_t bytes;
+  uint64_t checksum;
+};
+
+struct index_file_header {
+  static constexpr char expected_magic[8] = {'G', 'S', 'A', 'C',
+                                             'A', 'I', 'D', 'X'};
+  static constexpr uint32_t current_version = 1;
+  static constexpr uint64_t alignment = 4096;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t index_bytes; // width of SA, ISA and LCP entries
+  uint32_t symbol_bytes; // width of text and BWT symbols
+  uint32_t reserved;
+  uint64_t n; // text length including both sentinels
+  uint64_t max_symbol;
+  uint64_t text_hash;
+  index_section_entry sections[section_count];
+
+  bool has(index_section const section) const {
+    return sections[section].offset != 0;
+  }
+};
+
+struct index_file_options {
+  bool isa = false;
+  bool lcp = false;
+  bool bwt = false;
+  bool verify = false; // check the suffix array before publishing the file
+  size_t initial_sort_prefix_len = 2;
+  size_t threads = 0;
+};
+
+namespace index_file_internal {
+
+struct fingerprint_observer : no_observer {
+  streaming_fingerprint *fingerprint;
+
+  template<typename index_type>
+  gsaca_always_inline void phase_2_progress(index_type const *const,
+                                            size_t const border) {
+    fingerprint->update(border * sizeof(index_type));
+  }
+};
+
+}
+
+// Builds the suffix array with gsaca_ds_par directly into a file mapping and
+// adds the requested sections. The checksum of the suffix array is computed
+// while phase 2 finalizes it. The header is written last, i.e. an aborted
+// build never leaves a file with valid magic behind. The text_hash must be
+// the fingerprint of the text (n * sizeof(value_type) bytes). With the verify
+// option, an incorrect suffix array fails the build (see verify.hpp).
+template<typename index_type, typename value_type>
+static bool build_index_file(char const *const path,
+                             value_type const *const text, size_t const n,
+                             uint64_t const text_hash,
+                             index_file_options const &options) {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+
+  size_t const p = (options.threads == 0) ? omp_get_max_threads()
+                                          : options.threads;
+  uint64_t const alignment = index_file_header::alignment;
+
+  index_file_header header = {};
+  header.version = index_file_header::current_version;
+  header.index_bytes = sizeof(index_type);
+  header.symbol_bytes = sizeof(value_type);
+  header.n = n;
+  header.text_hash = text_hash;
+
+  uint64_t max_symbol = 0;
+  #pragma omp parallel for num_threads(p) reduction(max:max_symbol)
+  for (size_t i = 0; i < n; ++i) {
+    max_symbol = std::max(max_symbol, (uint64_t) text[i]);
+  }
+  header.max_symbol = max_symbol;
+
+  bool const present[section_count] = {true, options.isa, options.lcp,
+                                       options.bwt};
+  uint64_t const widths[section_count] = {sizeof(index_type),
+                                          sizeof(index_type),
+                                          sizeof(index_type),
+                                          sizeof(value_type)};
+  uint64_t file_bytes = alignment;
+  for (uint32_t s = 0; s < section_count; ++s) {
+    if (present[s]) {
+      header.sections[s].offset = file_bytes;
+      header.sections[s].bytes = n * widths[s];
+      file_bytes += (header.sections[s].bytes + alignment - 1) /
+                    alignment * alignment;
+    }
+  }
+
+  int const fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  if (ftruncate(fd, file_bytes) != 0) {
+    close(fd);
+    return false;
+  }
+  void *const base = mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return false;
+
+  auto section = [&](index_section const s) {
+      return ((uint8_t *) base) + header.sections[s].offset;
+  };
+  index_type *const sa = (index_type *) section(section_sa);
+
+  streaming_fingerprint sa_fingerprint(sa, n * sizeof(index_type));
+  gsaca_ds_par(text, sa, n, p, options.initial_sort_prefix_len,
+               index_file_internal::fingerprint_observer{{}, &sa_fingerprint});
+  header.sections[section_sa].checksum = sa_fingerprint.finish();
+
+  // the verifier computes the inverse suffix array as a side product
+  if (options.verify) {
+    index_type *const isa = options.isa
+        ? (index_type *) section(section_isa)
+        : (index_type *) malloc(n * sizeof(index_type));
+    bool const correct = verify_sa_parallel(text, sa, isa, n, p);
+    if (!options.isa) free(isa);
+    if (!correct) {
+      munmap(base, file_bytes);
+      return false;
+    }
+  } else if (options.isa) {
+    index_type *const isa = (index_type *) section(section_isa);
+    #pragma omp parallel for num_threads(p)
+    for (size_t i = 0; i < n; ++i) {
+      isa[(uint64_t) sa[i]] = i;
+    }
+  }
+  if (options.lcp) {
+    index_type *const lcp = (index_type *) section(section_lcp);
+    index_type *const plcp = (index_type *) malloc(n * sizeof(index_type));
+    plcp_by_phi_parallel(text, sa, plcp, n, p);
+    plcp_to_lcp_parallel(sa, plcp, lcp, n, p);
+    free(plcp);
+  }
+  if (options.bwt) {
+    value_type *const bwt = (value_type *) section(section_bwt);
+    #pragma omp parallel for num_threads(p)
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t const pos = sa[i];
+      bwt[i] = (pos > 0) ? text[pos - 1] : text[n - 1];
+    }
+  }
+  for (uint32_t s = section_isa; s < section_count; ++s) {
+    if (present[s]) {
+      header.sections[s].checksum = fingerprint_parallel(
+          section((index_section) s), header.sections[s].bytes, p);
+    }
+  }
+
+  memcpy(header.magic, index_file_header::expected_magic, 8);
+  memcpy(base, &header, sizeof(header));
+  bool const synced = msync(base, file_bytes, MS_SYNC) == 0;
+  munmap(base, file_bytes);
+  return synced;
+}
+
+template<typename index_type, typename value_type>
+static bool build_index_file(char const *const path,
+                             value_type const *const text, size_t const n,
+                             index_file_options const &options = {}) {
+  uint64_t const text_hash = fingerprint_parallel(
+      text, n * sizeof(value_type), options.threads);
+  return build_index_file<index_type>(path, text, n, text_hash, options);
+}
+
+// Read-only, zero-copy view of an index file. Mapping the file is cheap, the
+// arrays are paged in on first access. Checksums are only validated on
+// request, since this touches the whole file.
+template<typename index_type, typename value_type>
+class mapped_index {
+public:
+  mapped_index() = default;
+
+  explicit mapped_index(char const *const path) {
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        (size_t) st.st_size >= sizeof(index_file_header)) {
+      void *const base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED,
+                              fd, 0);
+      if (base != MAP_FAILED) {
+        base_ = (uint8_t const *) base;
+        mapped_bytes_ = st.st_size;
+        if (!valid_header()) {
+          munmap(base, mapped_bytes_);
+          base_ = nullptr;
+        }
+      }
+    }
+    close(fd);
+  }
+
+  mapped_index(mapped_index const &) = delete;
+
+  mapped_index &operator=(mapped_index const &) = delete;
+
+  mapped_index(mapped_index &&other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_index &operator=(mapped_index &&other) noexcept {
+    std::swap(base_, other.base_);
+    std::swap(mapped_bytes_, other.mapped_bytes_);
+    return *this;
+  }
+
+  ~mapped_index() {
+    if (base_ != nullptr) munmap((void *) base_, mapped_bytes_);
+  }
+
+  explicit operator bool() const {
+    return base_ != nullptr;
+  }
+
+  index_file_header const &header() const {
+    return *((index_file_header const *) base_);
+  }
+
+  size_t size() const {
+    return header().n;
+  }
+
+  // the arrays are nullptr if the section is not present
+  index_type const *sa() const {
+    return (index_type const *) section(section_sa);
+  }
+
+  index_type const *isa() const {
+    return (index_type const *) section(section_isa);
+  }
+
+  index_type const *lcp() const {
+    return (index_type const *) section(section_lcp);
+  }
+
+  value_type const *bwt() const {
+    return (value_type const *) section(section_bwt);
+  }
+
+  // advise the kernel to page in the given section ahead of time
+  void prefetch(index_section const s) const {
+    if (header().has(s)) {
+      madvise((void *) section(s), header().sections[s].bytes, MADV_WILLNEED);
+    }
+  }
+
+  bool matches_text(value_type const *const text, size_t const n,
+                    size_t const threads = 0) const {
+    return n == size() && header().text_hash ==
+                          fingerprint_parallel(text, n * sizeof(value_type),
+                                               threads);
+  }
+
+  bool verify_checksums(size_t const threads = 0) const {
+    for (uint32_t s = 0; s < section_count; ++s) {
+      auto const &entry = header().sections[s];
+      if (entry.offset != 0 &&
+          fingerprint_parallel(base_ + entry.offset, entry.bytes, threads) !=
+          entry.checksum) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  uint8_t const *section(index_section const s) const {
+    return header().has(s) ? (base_ + header().sections[s].offset) : nullptr;
+  }
+
+  bool valid_header() const {
+    auto const &h = header();
+    if (memcmp(h.magic, index_file_header::expected_magic, 8) != 0 ||
+        h.version != index_file_header::current_version ||
+        h.index_bytes != sizeof(index_type) ||
+        h.symbol_bytes != sizeof(value_type) || !h.has(section_sa)) {
+      return false;
+    }
+    for (uint32_t s = 0; s < section_count; ++s) {
+      auto const &entry = h.sections[s];
+      if (entry.offset != 0 &&
+          (entry.offset % index_file_header::alignment != 0 ||
+           entry.offset + entry.bytes > mapped_bytes_)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint8_t const *base_ = nullptr;
+  size_t mapped_bytes_ = 0;
+};
+
+}
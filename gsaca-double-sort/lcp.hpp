@@ -0,0 +1,71 @@
+#pragma once
+
+#include <omp.h>
+#include "uint_types.hpp"
+
+namespace gsaca_lyndon {
+
+// Computes the permuted LCP array (PLCP, in text order) from a suffix array
+// using the Phi array. Both sentinels (text[0] and text[n - 1]) are treated
+// as distinct symbols, i.e. plcp[0] = plcp[n - 1] = 0. Matching stops at the
+// separator symbol, which allows to compute the LCP array of a generalized
+// suffix array of documents separated by that symbol. The computation is done
+// in-place in plcp (Phi is overwritten by the lcp values).
+template<typename index_type, typename value_type, typename lcp_type>
+static void plcp_by_phi_parallel(value_type const *const text,
+                                 index_type const *const sa,
+                                 lcp_type *const plcp,
+                                 size_t const n, size_t const threads,
+                                 value_type const separator = 0) {
+  static_assert(std::is_unsigned<lcp_type>::value);
+
+  #pragma omp parallel for num_threads(threads)
+  for (size_t i = 1; i < n; ++i) {
+    plcp[(uint64_t) sa[i]] = sa[i - 1];
+  }
+  plcp[n - 1] = n - 1;
+  plcp[0] = n - 1;
+
+  // every chunk starts with lcp 0, afterwards the usual Kasai argument holds
+  #pragma omp parallel for num_threads(threads)
+  for (size_t t = 0; t < threads; ++t) {
+    size_t const chunk = n / threads + (n % threads > 0);
+    size_t const begin = t * chunk;
+    size_t const end = std::min(n, (t + 1) * chunk);
+
+    size_t l = 0;
+    for (size_t i = begin; i < end; ++i) {
+      size_t const j = plcp[i];
+      if (gsaca_unlikely(j == n - 1)) {
+        plcp[i] = 0;
+        l = 0;
+        continue;
+      }
+      while (text[i + l] == text[j + l] && text[i + l] != separator) ++l;
+      plcp[i] = l;
+      l -= (l > 0);
+    }
+  }
+}
+
+template<typename index_type, typename value_type, typename lcp_type>
+static void plcp_by_phi(value_type const *const text,
+                        index_type const *const sa,
+                        lcp_type *const plcp, size_t const n,
+                        value_type const separator = 0) {
+  plcp_by_phi_parallel(text, sa, plcp, n, 1, separator);
+}
+
+// Converts the PLCP array into the LCP array (in suffix array order).
+template<typename index_type, typename lcp_type>
+static void plcp_to_lcp_parallel(index_type const *const sa,
+                                 lcp_type const *const plcp,
+                                 lcp_type *const lcp, size_t const n,
+                                 size_t const threads) {
+  #pragma omp parallel for num_threads(threads)
+  for (size_t i = 0; i < n; ++i) {
+    lcp[i] = plcp[(uint64_t) sa[i]];
+  }
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace gsaca_lyndon {
+
+// Maps a file as a read-only text without copying it. The file content is
+// surrounded by the sentinels the construction relies on, i.e. text()[0] and
+// text()[size() - 1] are zero and the file content starts at text()[1]. The
+// file itself must not contain zero bytes.
+//
+// The sentinels are obtained for free: the file is mapped one page behind an
+// anonymous zero page, and the byte behind the end of the file is either part
+// of the (zero padded) last page of the file or of another anonymous page.
+class mapped_text {
+public:
+  mapped_text() = default;
+
+  explicit mapped_text(char const *const path) {
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      size_t const file_size = st.st_size;
+      size_t const page = sysconf(_SC_PAGESIZE);
+      size_t const file_pages = (file_size + page - 1) / page;
+      size_t const total = (file_pages + 2) * page;
+
+      void *const base = mmap(nullptr, total, PROT_READ,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base != MAP_FAILED) {
+        uint8_t *const file_begin = ((uint8_t *) base) + page;
+        void *const mapped = mmap(file_begin, file_size, PROT_READ,
+                                  MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (mapped != MAP_FAILED) {
+          madvise(file_begin, file_size, MADV_SEQUENTIAL);
+          base_ = base;
+          mapped_bytes_ = total;
+          text_ = file_begin - 1;
+          n_ = file_size + 2;
+        } else {
+          munmap(base, total);
+        }
+      }
+    }
+    close(fd);
+  }
+
+  mapped_text(mapped_text const &) = delete;
+
+  mapped_text &operator=(mapped_text const &) = delete;
+
+  mapped_text(mapped_text &&other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_text &operator=(mapped_text &&other) noexcept {
+    std::swap(base_, other.base_);
+    std::swap(mapped_bytes_, other.mapped_bytes_);
+    std::swap(text_, other.text_);
+    std::swap(n_, other.n_);
+    return *this;
+  }
+
+  ~mapped_text() {
+    if (base_ != nullptr) munmap(base_, mapped_bytes_);
+  }
+
+  explicit operator bool() const {
+    return text_ != nullptr;
+  }
+
+  uint8_t const *text() const {
+    return text_;
+  }
+
+  // length of the text including both sentinels
+  size_t size() const {
+    return n_;
+  }
+
+private:
+  void *base_ = nullptr;
+  size_t mapped_bytes_ = 0;
+  uint8_t const *text_ = nullptr;
+  size_t n_ = 0;
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include <omp.h>
 #include "../extract.hpp"
+#include "../periodic.hpp"
 #include "phase_1.hpp"
 #include "phase_2.hpp"
 
@@ -17,10 +18,16 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
   using p1_stack_type = phase_1_stack_type<buffer_type>;
   using p1_group_type = typename p1_stack_type::value_type;
   p1_stack_type result;
+  trace_scope phase("sort_by_prefix", n);
 
-  if (sizeof(value_type) == 1) {
+  // bytes and 16-bit symbols are sorted by counting (one bucket per symbol)
+  constexpr bool small_alphabet = sizeof(value_type) <= 2;
+  constexpr count_type symbols =
+      1ULL << (small_alphabet ? (sizeof(value_type) * 8) : 8);
+
+  if (sizeof(value_type) == 1 || (small_alphabet && prefix == 1)) {
     if (prefix == 1) {
-        std::vector<count_type> histogram_vec(256*threads);
+        std::vector<count_type> histogram_vec(symbols*threads);
         count_type* const histogram_cont = histogram_vec.data();
 
 		// counting
@@ -28,7 +35,8 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
 		for (size_t i = 0; i < threads; ++i) {
 		   count_type interval_begin = std::max((count_type) (i * (n / threads + (n % threads > 0))), (count_type)1);
 		   count_type interval_end = std::min((count_type) ((i + 1) * (n / threads + (n % threads > 0))), n-1);
-		   count_type* histogram = &(histogram_cont[256*i]);
+		   count_type* histogram = &(histogram_cont[symbols*i]);
+		   trace_scope chunk("sort_by_prefix count", interval_end - interval_begin);
 
 		   for (count_type j = interval_begin; j < interval_end; ++j) {
 		       ++histogram[text[j]];
@@ -37,10 +45,10 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
 
 		// calculate borders
 		count_type border = 2;
-		for (index_type i = 1; i < 256; ++i) {
+		for (index_type i = 1; i < symbols; ++i) {
 		    count_type gsize = 0;
 		    for (size_t j = 0; j < threads; ++j) {
-		        count_type bucket = 256*j+i;
+		        count_type bucket = symbols*j+i;
 		        count_type count = histogram_cont[bucket];
 		        histogram_cont[bucket] = border;
 		        border += count;
@@ -56,7 +64,8 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
 		for (size_t i = 0; i < threads; ++i) {
 		    count_type interval_begin = i * (n / threads + (n % threads > 0));
 		    count_type interval_end = std::min((count_type)((i + 1) * (n / threads + (n % threads > 0))), n);
-		    count_type* borders = &(histogram_cont[256*i]);
+		    count_type* borders = &(histogram_cont[symbols*i]);
+		    trace_scope chunk("sort_by_prefix distribute", interval_end - interval_begin);
 
 		    for (count_type j = interval_begin; j < interval_end; ++j) {
 		        sa[borders[text[j]]++] = j;
@@ -74,6 +83,7 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
           count_type interval_begin = std::max((count_type) (i * (n / threads + (n % threads > 0))), (count_type)1);
           count_type interval_end = std::min((count_type) ((i + 1) * (n / threads + (n % threads > 0))), stop);
           count_type* histogram = &(histogram_cont[buckets*i]);
+          trace_scope chunk("sort_by_prefix count", interval_end - interval_begin);
 
           for (count_type j = interval_begin; j < interval_end; ++j) {
               ++histogram[extract(text, j, prefix)];
@@ -108,6 +118,7 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
           count_type interval_begin = std::max(i * (n / threads + (n % threads > 0)), (size_t)1);
           count_type interval_end = std::min((count_type)((i + 1) * (n / threads + (n % threads > 0))), stop);
           count_type* borders = &(histogram_cont[buckets*i]);
+          trace_scope chunk("sort_by_prefix distribute", interval_end - interval_begin);
 
           for (count_type j = interval_begin; j < interval_end; ++j) {
               sa[borders[extract(text, j, prefix)]++] = F::conditional_add_flag(
@@ -136,23 +147,70 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
            auto extracted2 = safe_extract(text, b, prefix);
            return (extracted1 < extracted2) || ((extracted1 == extracted2) && a < b);
       };
-      ips4o::parallel::sort(&(sa[0]), &(sa[n]), comp);
-
-      // determine gsizes
-      // TODO: Parallelize
-      count_type left_border = 2;
-      count_type gsize = 1;
-      for (count_type i = 2; i < n-1; ++i) {
-          if (safe_extract(text, sa[i], prefix) == safe_extract(text, sa[i+1], prefix)) {
-              ++gsize;
+      {
+        trace_scope region("sort_by_prefix ips4o", n);
+        ips4o::parallel::sort(&(sa[0]), &(sa[n]), comp);
+      }
+
+      // determine groups: mark the first position of every group in a
+      // bitvector (chunks are word aligned), compact the marked positions
+      // into a contiguous array, and fill the phase 1 stack from it
+      {
+        trace_scope boundaries("sort_by_prefix group boundaries", n);
+        size_t const words = (n >> 6) + 1;
+        size_t const chunk_words = words / threads + (words % threads > 0);
+        std::vector<uint64_t> is_start(words);
+        std::vector<count_type> offsets(threads + 1, 0);
+
+        #pragma omp parallel for
+        for (size_t t = 0; t < threads; ++t) {
+          size_t const word_begin = std::min(words, t * chunk_words);
+          size_t const word_end = std::min(words, word_begin + chunk_words);
+          count_type const begin = std::max((size_t) 2, word_begin << 6);
+          count_type const end = std::min((size_t) n, word_end << 6);
+          count_type count = 0;
+          if (begin < end) {
+            auto previous = safe_extract(text, sa[begin - 1], prefix);
+            for (size_t w = word_begin; w < word_end; ++w) {
+              uint64_t word = 0;
+              count_type const stop = std::min((size_t) end, (w + 1) << 6);
+              for (count_type i = std::max((size_t) begin, w << 6); i < stop;
+                   ++i) {
+                auto const current = safe_extract(text, sa[i], prefix);
+                word |= ((uint64_t) (i == 2 || current != previous)) <<
+                        (i & 63);
+                previous = current;
+              }
+              is_start[w] = word;
+              count += __builtin_popcountll(word);
+            }
           }
-          else {
-              result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
-              left_border = i+1;
-              gsize = 1;
+          offsets[t + 1] = count;
+        }
+        for (size_t t = 0; t < threads; ++t) offsets[t + 1] += offsets[t];
+
+        count_type const number_of_groups = offsets[threads];
+        std::vector<count_type> starts(number_of_groups + 1);
+        starts[number_of_groups] = n;
+        #pragma omp parallel for
+        for (size_t t = 0; t < threads; ++t) {
+          size_t const word_begin = std::min(words, t * chunk_words);
+          size_t const word_end = std::min(words, word_begin + chunk_words);
+          count_type out = offsets[t];
+          for (size_t w = word_begin; w < word_end; ++w) {
+            for (uint64_t word = is_start[w]; word != 0; word &= word - 1) {
+              starts[out++] = (w << 6) + __builtin_ctzll(word);
+            }
           }
+        }
+
+        result.resize(number_of_groups);
+        #pragma omp parallel for
+        for (count_type g = 0; g < number_of_groups; ++g) {
+          result[g] = p1_group_type{starts[g], starts[g + 1] - starts[g], 1,
+                                    true, false};
+        }
       }
-      result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
 
       // add flags
       #pragma omp parallel for
@@ -166,16 +224,43 @@ auto sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
   return result;
 }
 
+template<typename buffer_type, typename F, typename index_type,
+    typename value_type, typename observer_type>
+static void gsaca_ds_par_phases(value_type const *const text,
+                                index_type *const sa, size_t const n,
+                                size_t const threads, size_t const prefix,
+                                observer_type observer, F const flags) {
+  observer.phase_begin(gsaca_phase::sort_by_prefix);
+  auto p1_input_groups =
+      sort_by_prefix_parallel<buffer_type, F>(text, sa, n, prefix, threads);
+  observer.phase_end(gsaca_phase::sort_by_prefix);
+  buffer_type *const isa = (buffer_type *) malloc(n * sizeof(buffer_type));
+
+  observer.phase_begin(gsaca_phase::phase_1);
+  auto p2_input_groups = phase_1_by_sorting_parallel<F>(sa, isa, p1_input_groups, threads, 0, observer);
+  observer.phase_end(gsaca_phase::phase_1);
+
+  if (!observer.stop_requested()) {
+    observer.phase_begin(gsaca_phase::phase_2);
+    phase_2_by_sorting_stable_parallel<F>(sa, isa, n, p2_input_groups.data(),
+                       p2_input_groups.size(), threads, observer, flags);
+    observer.phase_end(gsaca_phase::phase_2);
+  }
+  free(isa);
+}
+
 }
 
 template<typename buffer_type = auto_buffer_type,
     bool use_flags = true,
     typename index_type, // auto deduce
     typename value_type, // auto deduce
-    typename used_buffer_type = get_buffer_type <buffer_type, index_type>>
+    typename used_buffer_type = get_buffer_type <buffer_type, index_type>,
+    typename observer_type = no_observer>
 static void
 gsaca_ds_par(value_type const *const text, index_type *const sa, size_t const n, size_t const threads,
-         size_t const initial_sort_prefix_len = 1) {
+         size_t const initial_sort_prefix_len = 1,
+         observer_type observer = observer_type()) {
   static_assert(std::is_unsigned<value_type>::value);
   static_assert(std::is_unsigned<index_type>::value);
   static_assert(std::is_unsigned<used_buffer_type>::value);
@@ -189,16 +274,33 @@ gsaca_ds_par(value_type const *const text, index_type *const sa, size_t const n,
   omp_set_dynamic(0);
   omp_set_num_threads(p);
 
-  auto p1_input_groups =
-      double_sort_internal::sort_by_prefix_parallel<used_buffer_type, F>
-            (text, sa, n, initial_sort_prefix_len, p);
-  used_buffer_type *const isa = (used_buffer_type *) malloc(n * sizeof(used_buffer_type));
-
-  auto p2_input_groups = phase_1_by_sorting_parallel<F>(sa, isa, p1_input_groups, p);
-  
-  phase_2_by_sorting_stable_parallel<F>(sa, isa, n, p2_input_groups.data(),
-                     p2_input_groups.size(), p);
-  free(isa);
+  // periodic texts are sorted arithmetically (see periodic.hpp)
+  if (size_t const period = detect_period(text, n); period > 0) {
+    periodic_sa(text, sa, n, period, p, observer,
+                [&](value_type const *const y, index_type *const y_sa,
+                    size_t const y_n) {
+                    gsaca_ds_par<buffer_type, use_flags>(
+                        y, y_sa, y_n, p, initial_sort_prefix_len,
+                        periodic_internal::stop_observer::of(observer));
+                });
+    omp_set_num_threads(p_max);
+    return;
+  }
+
+  if constexpr (use_flags) {
+    // flags do not fit into the entries, keep them in a side bitvector
+    using count_type = get_count_type<index_type, used_buffer_type>;
+    if (!flag_bits_fit<index_type, used_buffer_type, count_type>(n)) {
+      flag_type_side const flags{flag_type_side::build(text, n, p)};
+      double_sort_internal::gsaca_ds_par_phases<used_buffer_type>(
+          text, sa, n, p, initial_sort_prefix_len, observer, flags);
+      free((void *) flags.bits);
+      omp_set_num_threads(p_max);
+      return;
+    }
+  }
+  double_sort_internal::gsaca_ds_par_phases<used_buffer_type>(
+      text, sa, n, p, initial_sort_prefix_len, observer, F());
 
   omp_set_num_threads(p_max);
 }
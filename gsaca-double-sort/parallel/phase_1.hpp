@@ -3,20 +3,25 @@
 #include <cstring>
 #include <omp.h>
 #include "../phase_types.hpp"
+#include "../trace.hpp"
 #include "phase_2.hpp"
 
 namespace gsaca_lyndon {
 
-template<typename F = flag_type<false>, typename index_type, typename buffer_type>
+template<typename F = flag_type<false>, typename index_type, typename buffer_type,
+         typename observer_type = no_observer>
 inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const isa,
                                phase_1_stack_type<buffer_type> &input_groups, size_t threads,
-                               size_t max_group_size = 0) {
+                               size_t max_group_size = 0,
+                               observer_type observer = observer_type()) {
   using count_type = get_count_type<index_type, buffer_type>;
   using output_type = phase_2_group_type<buffer_type>;
   using input_type = phase_1_group_type<buffer_type>;
   using sorting_type = radix_key_val_pair<buffer_type>;
+  trace_scope phase("phase_1", input_groups.size());
 
   if (max_group_size == 0) {
+    trace_scope region("phase_1 max group size", input_groups.size());
     #pragma omp parallel for reduction(max:max_group_size)
     for (count_type i = 0; i < input_groups.size(); ++i) {
       max_group_size = std::max(max_group_size, (size_t) input_groups[i].size);
@@ -30,14 +35,22 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
   memset(rank, 0, n * sizeof(buffer_type));
 
   std::vector<output_type> result_groups(1);
+  count_type assigned = 2; // the sentinels
 
-  // twice the size for out-of-place radix sort
-  sorting_type *to_sort = (sorting_type *) malloc(
-      (max_group_size) * sizeof(sorting_type) * 2);
+  // twice the size for out-of-place radix sort, plus one element in front
+  // (insertion sort uses to_sort[-1] as a sentinel)
+  sorting_type *const to_sort_memory = (sorting_type *) malloc(
+      (2 * max_group_size + 1) * sizeof(sorting_type));
+  sorting_type *const to_sort = to_sort_memory + 1;
 
   buffer_type *const subgroup_id = (buffer_type *) to_sort;
 
+  // small groups are processed by the calling thread only
+  trace_stretch sequential_groups("phase_1 sequential groups");
+
   while (!input_groups.empty()) {
+    observer.phase_1_progress(assigned, n);
+    if (gsaca_unlikely(observer.stop_requested())) break;
     auto const group = input_groups.back();
     input_groups.pop_back();
 
@@ -47,6 +60,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
     index_type *const sa_interval = &(sa[gstart]);
 
     if (gsize < seq_threshold) {
+        sequential_groups.extend();
         if (gsize == 1) {
             index_type const idx = F::remove_flag(sa_interval[0]);
             rank[idx] = result_groups.size();
@@ -55,6 +69,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
               context += result_groups[rank[idx + context]].lyndon;
             }
             result_groups.emplace_back(output_type{context, 1});
+            ++assigned;
           } else if (!group.check_for_runs) {
             // this group can directly be processed
             if (group.is_final) {
@@ -64,6 +79,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
                 rank[F::remove_flag(sa_interval[i])] = assign_rank;
               }
               result_groups.emplace_back(output_type{gcontext, gsize});
+              assigned += gsize;
             } else {
               // let's sort the group by the rank behind the context
               for (count_type i = 0; i < gsize; ++i) {
@@ -154,34 +170,47 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
         }
     }
     else {
+        sequential_groups.close();
+        trace_scope large_group("phase_1 large group", gsize);
         if (!group.check_for_runs) {
           if (group.is_final) {
             // great! we can assign the rank!
             buffer_type const assign_rank = result_groups.size();
+            trace_scope region("phase_1 assign rank", gsize);
             #pragma omp parallel for
             for (count_type i = 0; i < gsize; ++i) {
               rank[F::remove_flag(sa_interval[i])] = assign_rank;
             }
             result_groups.emplace_back(output_type{gcontext, gsize});
+            assigned += gsize;
           } else {
             // let's sort the group by the rank behind the context
-            #pragma omp parallel for
-            for (count_type i = 0; i < gsize; ++i) {
-              to_sort[i].value = sa_interval[i];
-            }
-            #pragma omp parallel for
-            for (count_type i = 0; i < gsize; ++i) {
-              to_sort[i].key = rank[F::remove_flag(to_sort[i].value) + gcontext];
+            {
+              trace_scope region("phase_1 gather keys", gsize);
+              #pragma omp parallel for
+              for (count_type i = 0; i < gsize; ++i) {
+                to_sort[i].value = sa_interval[i];
+              }
+              #pragma omp parallel for
+              for (count_type i = 0; i < gsize; ++i) {
+                to_sort[i].key = rank[F::remove_flag(to_sort[i].value) + gcontext];
+              }
             }
 
             auto comp = [&](auto a, auto b) {
-               return a.key > b.key || (a.key == b.key && a.value < b.value);
+               return a.key > b.key || (a.key == b.key && F::remove_flag(a.value) < F::remove_flag(b.value));
             };
-            ips4o::parallel::sort(&(to_sort[0]), &(to_sort[gsize]), comp, threads);
+            {
+              trace_scope region("phase_1 ips4o", gsize);
+              ips4o::parallel::sort(&(to_sort[0]), &(to_sort[gsize]), comp, threads);
+            }
 
-            #pragma omp parallel for
-            for (count_type i = 0; i < gsize; ++i) {
-              sa_interval[i] = to_sort[i].value;
+            {
+              trace_scope region("phase_1 scatter", gsize);
+              #pragma omp parallel for
+              for (count_type i = 0; i < gsize; ++i) {
+                sa_interval[i] = to_sort[i].value;
+              }
             }
 
             // calculate sg_count
@@ -191,6 +220,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
             for (size_t i = 0; i < threads; ++i) {
                 count_type interval_begin = i * (gsize / threads);
                 count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
+                trace_scope chunk("phase_1 count subgroups", interval_end - interval_begin);
 
                 buffer_type sg_key = to_sort[interval_begin].key;
                 sg_count_thread[i] = (((i == 0) || (to_sort[interval_begin-1].key != sg_key)) ? 1 : 0);
@@ -215,6 +245,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
             for (size_t i = 0; i < threads; ++i) {
                 count_type interval_begin = i * (gsize / threads);
                 count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
+                trace_scope chunk("phase_1 subgroup borders", interval_end - interval_begin);
 
                 buffer_type sg_key = to_sort[interval_begin].key;
                 if ((i == 0) || (to_sort[interval_begin-1].key != sg_key)) {
@@ -258,6 +289,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
           for (size_t i = 0; i < threads; ++i) {
               count_type interval_begin = i * (gsize / threads);
               count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
+              trace_scope chunk("phase_1 subgroup ids", interval_end - interval_begin);
 
               if (i != threads-1) {
                   subgroup_id[interval_end - 1] =
@@ -294,9 +326,12 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
               }
           }
           size_t max_group = 0;
-          #pragma omp parallel for reduction(max:max_group)
-          for (count_type i = 0; i < gsize; ++i) {
-              max_group = std::max(max_group, (size_t) subgroup_id[i]);
+          {
+            trace_scope region("phase_1 max subgroup", gsize);
+            #pragma omp parallel for reduction(max:max_group)
+            for (count_type i = 0; i < gsize; ++i) {
+                max_group = std::max(max_group, (size_t) subgroup_id[i]);
+            }
           }
           buffer_type first_empty_subgroup = max_group + 1;
 
@@ -313,6 +348,7 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
               count_type interval_begin = i * (gsize / threads);
               count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
               buffer_type* subgroup_size_thread = &(subgroup_size[i*first_empty_subgroup]);
+              trace_scope chunk("phase_1 subgroup sizes", interval_end - interval_begin);
 
               for (count_type j = interval_begin; j < interval_end; ++j) {
                   ++subgroup_size_thread[subgroup_id[j]];
@@ -355,19 +391,23 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
               count_type interval_begin = i * (gsize / threads);
               count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
               buffer_type* subgroup_size_thread = &(subgroup_size[i*first_empty_subgroup]);
+              trace_scope chunk("phase_1 distribute", interval_end - interval_begin);
 
               for (count_type j = interval_begin; j < interval_end; ++j) {
                   buffer_type &border = subgroup_size_thread[subgroup_id[j]];
                   subgroup_id[j] = border++;
               }
           }
-          #pragma omp parallel for
-          for (count_type i = 0; i < gsize; ++i) {
-            subgroup_size[subgroup_id[i]] = sa_interval[i];
-          }
-          #pragma omp parallel for
-          for (count_type i = 0; i < gsize; ++i) {
-            sa_interval[i] = subgroup_size[i];
+          {
+            trace_scope region("phase_1 permute", gsize);
+            #pragma omp parallel for
+            for (count_type i = 0; i < gsize; ++i) {
+              subgroup_size[subgroup_id[i]] = sa_interval[i];
+            }
+            #pragma omp parallel for
+            for (count_type i = 0; i < gsize; ++i) {
+              sa_interval[i] = subgroup_size[i];
+            }
           }
 
           if (gsaca_unlikely(threads*first_empty_subgroup > max_group_size)) {
@@ -376,13 +416,14 @@ inline auto phase_1_by_sorting_parallel(index_type *const sa, buffer_type *const
         }
     }
   }
+  sequential_groups.close();
   result_groups.emplace_back(output_type{n - 1, 1});
   result_groups.emplace_back(output_type{1, 1});
   sa[0] = n - 1;
   sa[1] = 0;
   std::reverse(result_groups.begin(), result_groups.end());
   result_groups.resize(result_groups.size() - 1);
-  free(to_sort);
+  free(to_sort_memory);
   return result_groups;
 }
 
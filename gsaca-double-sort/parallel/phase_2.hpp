@@ -1,30 +1,39 @@
 #pragma once
 
 #include <omp.h>
+#include "../phase_types.hpp"
 #include "../uint_types.hpp"
 #include "../radix32.hpp"
+#include "../trace.hpp"
 
 namespace gsaca_lyndon {
     
-const size_t seq_threshold = 1025;
+const size_t seq_threshold = sorter_tuning::parallel_threshold;
 
-template<typename F = flag_type<false>, typename index_type, typename buffer_type>
+template<typename F = flag_type<false>, typename index_type, typename buffer_type,
+         typename observer_type = no_observer>
 inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type *const isa, size_t const n,
                                phase_2_group_type<buffer_type> const *const groups,
-                               size_t const number_of_groups, size_t threads) {
+                               size_t const number_of_groups, size_t threads,
+                               observer_type observer = observer_type(),
+                               F const flags = F()) {
   using count_type = get_count_type<index_type, buffer_type>;
   using key_value_pair = radix_key_val_pair<buffer_type>;
+  trace_scope phase("phase_2", number_of_groups);
 
   count_type max_group_size = 0;
-  #pragma omp parallel for reduction(max:max_group_size)
-  for (count_type g = 0; g < number_of_groups; ++g) {
-    max_group_size = std::max(max_group_size, (count_type) groups[g].size);
+  {
+    trace_scope region("phase_2 max group size", number_of_groups);
+    #pragma omp parallel for reduction(max:max_group_size)
+    for (count_type g = 0; g < number_of_groups; ++g) {
+      max_group_size = std::max(max_group_size, (count_type) groups[g].size);
+    }
   }
 
   constexpr count_type sg_count_threshold = 256ULL * 1024; // 1MiB buffer
   void *memory = malloc(
       sg_count_threshold * sizeof(count_type) +
-      ((max_group_size + 1) << 1) * sizeof(key_value_pair));
+      (((size_t) max_group_size + 1) << 1) * sizeof(key_value_pair));
 
   count_type *const subgroup_border_buffer = (count_type *) memory;
   key_value_pair *grouped_indices = (key_value_pair *) (subgroup_border_buffer +
@@ -38,9 +47,15 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
 
   count_type left_border = 2;
 
+  // small groups are processed by the calling thread only
+  trace_stretch sequential_groups("phase_2 sequential groups");
+
   for (count_type g = 2; g < number_of_groups; ++g) {
+    if (gsaca_unlikely(observer.stop_requested())) break;
     count_type const gsize = groups[g].size;
 
+    if (gsize < seq_threshold) sequential_groups.extend();
+
     if (gsize == 1) {
       sa[left_border] = F::remove_flag(sa[left_border]);
       isa[sa[left_border]] = left_border;
@@ -94,7 +109,8 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
               F::remove_flag(grouped_indices[i].value) + lyn];
         }
 
-        if (gsaca_likely(stop - previous_border < 33)) {
+        if (gsaca_likely(stop - previous_border <=
+                         radix_internal::insertion_threshold)) {
           radix_internal::insertion<true>(
               &(grouped_indices[previous_border]), stop - previous_border);
         } else {
@@ -107,7 +123,7 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
           sa_interval[i] = grouped_indices[i].value;
         }
         for (count_type i = previous_border; i < stop; ++i) {
-          if (!F::is_flagged(sa_interval[i])) {
+          if (!flags.is_flagged(sa_interval[i])) {
             isa[sa_interval[i]] = left_border + i;
           } else {
             sa_interval[i] = F::remove_flag(sa_interval[i]);
@@ -123,6 +139,8 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
       left_border += gsize;
     }
     else {
+      sequential_groups.close();
+      trace_scope large_group("phase_2 large group", gsize);
       buffer_type const lyn = groups[g].lyndon;
       index_type *const sa_interval = &(sa[left_border]);
 
@@ -132,6 +150,7 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
       for (size_t i = 0; i < threads; ++i) {
           count_type interval_begin = i * (gsize / threads);
           count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
+          trace_scope chunk("phase_2 subgroup ids", interval_end - interval_begin);
 
           length_end[i] = 1;
           subgroup_id[interval_end-1] = 0;
@@ -155,9 +174,12 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
           }
       }
       count_type sg_count = 1;
-      #pragma omp parallel for reduction(max:sg_count)
-      for (count_type i = 0; i < gsize; ++i) {
-          sg_count = std::max(sg_count, (count_type) subgroup_id[i]+1);
+      {
+        trace_scope region("phase_2 subgroup count", gsize);
+        #pragma omp parallel for reduction(max:sg_count)
+        for (count_type i = 0; i < gsize; ++i) {
+            sg_count = std::max(sg_count, (count_type) subgroup_id[i]+1);
+        }
       }
 
       count_type *const subgroup_border =
@@ -174,6 +196,7 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
           count_type interval_begin = i * (gsize / threads);
           count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
           count_type* subgroup_sizes = &(subgroup_border[i*sg_count]);
+          trace_scope chunk("phase_2 subgroup sizes", interval_end - interval_begin);
 
           for (count_type j = interval_begin; j < interval_end; ++j) {
               ++subgroup_sizes[subgroup_id[j]];
@@ -197,6 +220,7 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
           count_type interval_begin = i * (gsize / threads);
           count_type interval_end = i < threads-1 ? (count_type)((i + 1) * (gsize / threads)) : gsize;
           count_type* subgroup_border_thread = &(subgroup_border[i*sg_count]);
+          trace_scope chunk("phase_2 distribute", interval_end - interval_begin);
 
           for (count_type j = interval_begin; j < interval_end; ++j) {
               count_type &border = subgroup_border_thread[subgroup_id[j]];
@@ -208,23 +232,30 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
       for (count_type j = 0; j < sg_count; ++j) {
         count_type const stop = subgroup_border[(threads-1)*sg_count+j]; // last chunk contains end borders
         // retrieve lexicographical rank of inducers
-        #pragma omp parallel for
-        for (count_type i = previous_border; i < stop; ++i) {
-          grouped_indices[i].key = isa[F::remove_flag(grouped_indices[i].value) + lyn];
+        {
+          trace_scope region("phase_2 gather keys", stop - previous_border);
+          #pragma omp parallel for
+          for (count_type i = previous_border; i < stop; ++i) {
+            grouped_indices[i].key = isa[F::remove_flag(grouped_indices[i].value) + lyn];
+          }
         }
 
         auto comp = [&](auto a, auto b) {
            return a.key < b.key;
         };
-        ips4o::parallel::sort(&(grouped_indices[previous_border]), &(grouped_indices[stop]), comp, threads);
+        {
+          trace_scope region("phase_2 ips4o", stop - previous_border);
+          ips4o::parallel::sort(&(grouped_indices[previous_border]), &(grouped_indices[stop]), comp, threads);
+        }
 
+        trace_scope region("phase_2 scatter", stop - previous_border);
         #pragma omp parallel for
         for (count_type i = previous_border; i < stop; ++i) {
           sa_interval[i] = grouped_indices[i].value;
         }
         #pragma omp parallel for
         for (count_type i = previous_border; i < stop; ++i) {
-            if (!F::is_flagged(sa_interval[i])) {
+            if (!flags.is_flagged(sa_interval[i])) {
               isa[sa_interval[i]] = left_border + i;
             } else {
               sa_interval[i] = F::remove_flag(sa_interval[i]);
@@ -233,13 +264,17 @@ inline void phase_2_by_sorting_stable_parallel(index_type *const sa, buffer_type
         previous_border = stop;
       }
 
-      if (gsaca_unlikely(sg_count >= sg_count_threshold)) {
+      if (gsaca_unlikely(threads*sg_count >= sg_count_threshold)) {
         free(subgroup_border);
       }
 
       left_border += gsize;
     }
+    observer.phase_2_progress(sa, left_border);
   }
+  sequential_groups.close();
+
+  free(memory);
 }
 
 
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "sequential/gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+// Partial suffix sorting: computes only the part of the suffix array that
+// contains the suffixes starting with one of the given patterns. The text
+// uses the usual sentinels, patterns are non-empty and free of zeros.
+//
+// One scan over the text finds the matching suffixes and, for every pattern,
+// the number of smaller suffixes (its first index in the full suffix array).
+// The matching suffixes are sorted by multikey quicksort, starting behind
+// the pattern. Time and memory of the sorting are proportional to the number
+// of matches and their common prefixes. If the sort inspects too many
+// symbols (long repeats), the full suffix array is computed by gsaca_ds
+// instead and the slice is copied from it.
+struct partial_interval {
+  uint64_t sa_begin; // first index in the full suffix array
+  uint64_t begin;    // first index in the slice
+  uint64_t end;      // behind the last index in the slice
+};
+
+namespace partial_internal {
+
+constexpr size_t insertion_threshold = 16;
+// at most this many inspected symbols per text symbol, otherwise gsaca_ds is
+// used (an inspected symbol costs about a tenth of a symbol of gsaca_ds)
+constexpr size_t max_work_factor = 8;
+
+// compares the suffix at i with the pattern, 0 if the pattern is a prefix
+template<typename value_type>
+static int compare(value_type const *const text, uint64_t const i,
+                   std::vector<value_type> const &pattern) {
+  for (size_t t = 0; t < pattern.size(); ++t) {
+    // stops at the final sentinel, which is smaller than any pattern symbol
+    if (text[i + t] != pattern[t]) return (text[i + t] < pattern[t]) ? -1 : 1;
+  }
+  return 0;
+}
+
+// Sorts the suffixes at pos[0, m), which share their first depth symbols.
+// Returns false once more than budget symbols have been inspected.
+template<typename value_type, typename index_type>
+static bool multikey_sort(value_type const *const text, index_type *pos,
+                          size_t m, size_t depth, size_t &budget) {
+  while (m > insertion_threshold) {
+    if (m > budget) return false;
+    budget -= m;
+    auto const symbol = [&](size_t const k) {
+        return text[(uint64_t) pos[k] + depth];
+    };
+    value_type const a = symbol(0), b = symbol(m / 2), c = symbol(m - 1);
+    value_type const pivot = std::max(std::min(a, b),
+                                      std::min(std::max(a, b), c));
+    size_t lt = 0, i = 0, gt = m;
+    while (i < gt) {
+      value_type const s = symbol(i);
+      if (s < pivot) std::swap(pos[lt++], pos[i++]);
+      else if (s > pivot) std::swap(pos[i], pos[--gt]);
+      else ++i;
+    }
+    if (!multikey_sort(text, pos, lt, depth, budget) ||
+        !multikey_sort(text, pos + gt, m - gt, depth, budget)) {
+      return false;
+    }
+    // at most one suffix reaches the final sentinel
+    if (pivot == 0) return true;
+    pos += lt;
+    m = gt - lt;
+    ++depth;
+  }
+  for (size_t a = 1; a < m; ++a) {
+    index_type const p = pos[a];
+    size_t b = a;
+    for (; b > 0; --b) {
+      uint64_t const q = pos[b - 1];
+      size_t d = depth;
+      while (text[q + d] == text[(uint64_t) p + d]) ++d;
+      if (d - depth >= budget) return false;
+      budget -= d - depth + 1;
+      if (text[q + d] < text[(uint64_t) p + d]) break;
+      pos[b] = pos[b - 1];
+    }
+    pos[b] = p;
+  }
+  return true;
+}
+
+}
+
+// Writes the suffixes of text starting with any of the patterns to slice, in
+// suffix array order, and for every pattern (in the given order) its
+// interval in the slice and in the full suffix array. Returns false if a
+// pattern is empty or contains a zero.
+template<typename index_type, typename value_type>
+static bool partial_gsaca_ds(value_type const *const text, size_t const n,
+                             std::vector<std::vector<value_type>> const &
+                             patterns,
+                             std::vector<index_type> &slice,
+                             std::vector<partial_interval> &intervals) {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+  using partial_internal::compare;
+
+  for (auto const &pattern : patterns) {
+    if (pattern.empty() ||
+        std::find(pattern.begin(), pattern.end(), 0) != pattern.end()) {
+      return false;
+    }
+  }
+
+  // Drop patterns extending another pattern. The remaining ones are prefix
+  // free, thus a suffix matches at most one of them: the largest one that is
+  // not larger than the suffix.
+  std::vector<std::vector<value_type>> sorted = patterns;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<std::vector<value_type>> reduced;
+  for (auto const &pattern : sorted) {
+    if (!reduced.empty() && pattern.size() >= reduced.back().size() &&
+        std::equal(reduced.back().begin(), reduced.back().end(),
+                   pattern.begin())) {
+      continue;
+    }
+    reduced.push_back(pattern);
+  }
+  size_t const k = reduced.size();
+
+  // smaller[j] counts the suffixes smaller than reduced[j] but not smaller
+  // than reduced[j - 1] (the smaller patterns form a suffix of reduced)
+  std::vector<uint64_t> smaller(k + 1, 0);
+  std::vector<std::vector<index_type>> matches(k);
+  for (uint64_t i = 0; i < n; ++i) {
+    size_t lo = 0, hi = k;
+    while (lo < hi) {
+      size_t const mid = (lo + hi) / 2;
+      if (compare(text, i, reduced[mid]) < 0) hi = mid;
+      else lo = mid + 1;
+    }
+    ++smaller[lo];
+    if (lo > 0 && compare(text, i, reduced[lo - 1]) == 0) {
+      matches[lo - 1].push_back(i);
+    }
+  }
+
+  std::vector<uint64_t> sa_begin(k);
+  std::vector<uint64_t> slice_begin(k + 1, 0);
+  uint64_t rank = 0;
+  for (size_t j = 0; j < k; ++j) {
+    rank += smaller[j];
+    sa_begin[j] = rank;
+    slice_begin[j + 1] = slice_begin[j] + matches[j].size();
+  }
+
+  slice.resize(slice_begin[k]);
+  size_t budget = partial_internal::max_work_factor * n;
+  bool sorted_all = true;
+  for (size_t j = 0; j < k && sorted_all; ++j) {
+    std::copy(matches[j].begin(), matches[j].end(),
+              slice.begin() + slice_begin[j]);
+    std::vector<index_type>().swap(matches[j]);
+    sorted_all = partial_internal::multikey_sort(
+        text, slice.data() + slice_begin[j], slice_begin[j + 1] -
+                                             slice_begin[j],
+        reduced[j].size(), budget);
+  }
+  if (!sorted_all) {
+    index_type *const sa = (index_type *) malloc(n * sizeof(index_type));
+    gsaca_ds(text, sa, n);
+    for (size_t j = 0; j < k; ++j) {
+      std::copy(sa + sa_begin[j],
+                sa + sa_begin[j] + (slice_begin[j + 1] - slice_begin[j]),
+                slice.begin() + slice_begin[j]);
+    }
+    free(sa);
+  }
+
+  // every pattern lies in the interval of the reduced pattern it extends
+  intervals.resize(patterns.size());
+  for (size_t p = 0; p < patterns.size(); ++p) {
+    auto const &pattern = patterns[p];
+    size_t const j = std::upper_bound(reduced.begin(), reduced.end(),
+                                      pattern) - reduced.begin() - 1;
+    auto const first = slice.begin() + slice_begin[j];
+    auto const last = slice.begin() + slice_begin[j + 1];
+    auto const begin = std::partition_point(first, last,
+                                            [&](index_type const i) {
+                                                return compare(text, i,
+                                                               pattern) < 0;
+                                            });
+    auto const end = std::partition_point(begin, last,
+                                          [&](index_type const i) {
+                                              return compare(text, i,
+                                                             pattern) == 0;
+                                          });
+    intervals[p].sa_begin = sa_begin[j] + (begin - first);
+    intervals[p].begin = begin - slice.begin();
+    intervals[p].end = end - slice.begin();
+  }
+  return true;
+}
+
+}
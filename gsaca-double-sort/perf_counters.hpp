@@ -0,0 +1,146 @@
+#pragma once
+
+#include <omp.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gsaca_lyndon {
+
+enum perf_counter : uint32_t {
+  counter_cycles = 0,
+  counter_instructions = 1,
+  counter_llc_misses = 2,
+  counter_dtlb_misses = 3,
+  counter_branch_misses = 4,
+  counter_count = 5
+};
+
+constexpr char const *perf_counter_names[counter_count] = {
+    "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+
+struct perf_counter_values {
+  uint64_t value[counter_count] = {};
+  bool available[counter_count] = {};
+};
+
+// Hardware performance counters of all threads of an OpenMP team, based on
+// Linux perf_event_open. Each thread of the team opens its own counters
+// (user space only), and read returns the sum over all threads, scaled up if
+// the kernel had to multiplex the counters. Counters that cannot be opened
+// (no PMU access, perf_event_paranoid, virtual machines, other operating
+// systems) are reported as unavailable, everything else keeps working.
+//
+// The counters are bound to the threads that exist at construction, i.e. to
+// the OpenMP thread pool, which is reused by all later parallel regions of
+// at most the same size.
+class perf_counters {
+public:
+  explicit perf_counters(size_t const threads = 0)
+      : fds_((threads == 0) ? omp_get_max_threads() : threads) {
+    for (auto &thread_fds : fds_) thread_fds.fill(-1);
+#ifdef __linux__
+    #pragma omp parallel num_threads(fds_.size())
+    {
+      auto &thread_fds = fds_[omp_get_thread_num()];
+      for (uint32_t c = 0; c < counter_count; ++c) {
+        thread_fds[c] = open_counter((perf_counter) c);
+      }
+    }
+#endif
+  }
+
+  perf_counters(perf_counters const &) = delete;
+
+  perf_counters &operator=(perf_counters const &) = delete;
+
+  ~perf_counters() {
+#ifdef __linux__
+    for (auto const &thread_fds : fds_) {
+      for (int const fd : thread_fds) {
+        if (fd >= 0) close(fd);
+      }
+    }
+#endif
+  }
+
+  bool available() const {
+    auto const values = read();
+    for (bool const a : values.available) {
+      if (a) return true;
+    }
+    return false;
+  }
+
+  perf_counter_values read() const {
+    perf_counter_values result;
+#ifdef __linux__
+    for (uint32_t c = 0; c < counter_count; ++c) {
+      // only report a counter if all threads could open it
+      bool available = true;
+      double sum = 0;
+      for (auto const &thread_fds : fds_) {
+        uint64_t buffer[3]; // value, time enabled, time running
+        if (thread_fds[c] < 0 ||
+            ::read(thread_fds[c], buffer, sizeof(buffer)) !=
+            (ssize_t) sizeof(buffer)) {
+          available = false;
+          break;
+        }
+        sum += (buffer[2] == 0) ? 0.0 : (double) buffer[0] *
+                                        ((double) buffer[1] / buffer[2]);
+      }
+      result.available[c] = available;
+      result.value[c] = available ? (uint64_t) sum : 0;
+    }
+#endif
+    return result;
+  }
+
+private:
+#ifdef __linux__
+  static int open_counter(perf_counter const counter) {
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (counter) {
+      case counter_cycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case counter_instructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case counter_llc_misses:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+      case counter_dtlb_misses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+      default:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    }
+    // pid = 0, cpu = -1: the calling thread on any cpu
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+#endif
+
+  std::vector<std::array<int, counter_count>> fds_;
+};
+
+}
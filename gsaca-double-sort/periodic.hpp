@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "phase_types.hpp"
+#include "uint_types.hpp"
+
+namespace gsaca_lyndon {
+
+// Fast path for periodic texts (e.g. aaaa..., abab..., or a tandem repeat
+// u^k u' spanning the whole text). Let x = text[1, n - 1) have smallest
+// period p, i.e. u = x[0, p) is primitive. A suffix of x of length at least
+// p starts with the rotation of u given by its position modulo p, and all
+// rotations of u are distinct. Thus, the suffixes of length at least p are
+// ordered by their rotation first and by increasing length second, and every
+// shorter suffix compares the same way to all suffixes of one rotation. The
+// suffix array follows from the order of the last 2p - 1 suffixes of x,
+// which contain exactly one suffix of length at least p per rotation (the
+// shortest one): each of them is replaced by the chain of all suffixes
+// i, i - p, i - 2p, ... of its rotation.
+
+namespace periodic_internal {
+
+// periods up to half of this prefix length are detected
+constexpr size_t max_prefix = 1ULL << 20;
+// below this length, the last 2p - 1 suffixes are sorted by comparison
+constexpr size_t naive_sort_threshold = 256;
+// candidate periods must repeat this many leading symbols
+constexpr size_t candidate_window = 8;
+// symbols compared for candidates (per prefix symbol) before falling back to
+// the failure function
+constexpr size_t candidate_budget = 1;
+
+// Observer for the sort of the last 2p - 1 suffixes: their suffix array is
+// not the one the caller observes, thus only stop requests are forwarded.
+// The caller is type-erased, such that the recursion (a periodic reduced
+// text) instantiates the engines with this observer type only.
+struct stop_observer : no_observer {
+  void const *outer;
+  bool (*outer_stop_requested)(void const *);
+
+  template<typename observer_type>
+  static stop_observer of(observer_type const &observer) {
+    return {{}, &observer, [](void const *const o) {
+        return ((observer_type const *) o)->stop_requested();
+    }};
+  }
+
+  gsaca_always_inline bool stop_requested() const {
+    return outer_stop_requested(outer);
+  }
+};
+
+// smallest period of x[0, k) using the failure function of KMP
+template<typename value_type>
+static size_t smallest_period(value_type const *const x, size_t const k) {
+  uint32_t *const border = (uint32_t *) malloc(k * sizeof(uint32_t));
+  border[0] = 0;
+  for (size_t i = 1; i < k; ++i) {
+    uint32_t b = border[i - 1];
+    while (b > 0 && x[i] != x[b]) b = border[b - 1];
+    border[i] = b + (x[i] == x[b]);
+    // the period of a prefix never decreases
+    if (gsaca_unlikely(2 * (i + 1 - border[i]) > k)) {
+      free(border);
+      return k;
+    }
+  }
+  size_t const result = k - border[k - 1];
+  free(border);
+  return result;
+}
+
+}
+
+// Returns the smallest period p of text[1, n - 1) if it is at most half of
+// the length (and at most max_prefix / 2), or 0 otherwise. Candidates q are
+// the shifts at which the first few symbols repeat; each one is checked
+// against the whole interior (stopping at the first mismatch), thus most
+// texts are rejected by a single scan over the prefix. If the candidates get
+// too expensive (e.g. aaa...ab), the smallest period p of the prefix of
+// length k is computed instead: if p <= k / 2, then every period q <= k / 2
+// of the whole interior is a multiple of p (Fine and Wilf), so it suffices
+// to check p.
+template<typename value_type>
+static size_t detect_period(value_type const *const text, size_t const n) {
+  using namespace periodic_internal;
+  if (n < 6) return 0;
+  value_type const *const x = text + 1;
+  size_t const m = n - 2;
+  size_t const k = std::min(m, max_prefix);
+  if (k >= 2 * candidate_window) {
+    uint64_t budget = candidate_budget * k;
+    size_t q = 1;
+    for (; 2 * q <= k; ++q) {
+      if (memcmp(x + q, x, candidate_window * sizeof(value_type)) != 0) {
+        continue;
+      }
+      uint64_t const limit = std::min(m - q, budget);
+      uint64_t const matched =
+          std::mismatch(x + q, x + q + limit, x).first - (x + q);
+      if (matched == m - q) return q;
+      if (matched == budget) break;
+      budget -= matched;
+    }
+    if (2 * q > k) return 0;
+  }
+  size_t const p = smallest_period(x, k);
+  if (2 * p > k) return 0;
+  return (memcmp(x + p, x, (m - p) * sizeof(value_type)) == 0) ? p : 0;
+}
+
+// Computes the suffix array of a text whose interior has smallest period p
+// (see detect_period). The last 2p - 1 suffixes are sorted either by
+// comparison or by sort_text(y, y_sa, y_n), which gets a text with sentinels
+// and has to write its suffix array (e.g. a call to gsaca_ds with a
+// periodic_internal::stop_observer). Writing the chains is reported to the
+// observer as phase 2; it checks stop_requested between chains.
+template<typename index_type, typename value_type, typename observer_type,
+    typename sort_function>
+static void periodic_sa(value_type const *const text, index_type *const sa,
+                        size_t const n, size_t const p, size_t const threads,
+                        observer_type &observer, sort_function &&sort_text) {
+  value_type const *const x = text + 1;
+  size_t const m = n - 2;
+  size_t const l = 2 * p - 1;
+  size_t const s = m - l;
+
+  // order of the suffixes of x starting in [s, m)
+  uint64_t *const order = (uint64_t *) malloc(l * sizeof(uint64_t));
+  if (l <= periodic_internal::naive_sort_threshold) {
+    for (size_t j = 0; j < l; ++j) order[j] = s + j;
+    std::sort(order, order + l, [&](uint64_t const a, uint64_t const b) {
+        // a != b, the shorter suffix is smaller if it is a prefix
+        size_t const len = m - std::max(a, b);
+        for (size_t i = 0; i < len; ++i) {
+          if (x[a + i] != x[b + i]) return x[a + i] < x[b + i];
+        }
+        return a > b;
+    });
+  } else {
+    value_type *const y = (value_type *) malloc((l + 2) * sizeof(value_type));
+    index_type *const y_sa = (index_type *) malloc((l + 2) *
+                                                   sizeof(index_type));
+    y[0] = y[l + 1] = 0;
+    memcpy(y + 1, x + s, l * sizeof(value_type));
+    sort_text((value_type const *) y, y_sa, l + 2);
+    for (size_t j = 0; j < l; ++j) order[j] = s + (uint64_t) y_sa[j + 2] - 1;
+    free(y_sa);
+    free(y);
+    if (observer.stop_requested()) {
+      free(order);
+      return;
+    }
+  }
+
+  // offsets[j] is the first output position of the chain of order[j]
+  uint64_t *const offsets = (uint64_t *) malloc((l + 1) * sizeof(uint64_t));
+  offsets[0] = 2;
+  for (size_t j = 0; j < l; ++j) {
+    uint64_t const i = order[j];
+    offsets[j + 1] = offsets[j] + ((m - i < p) ? 1 : i / p + 1);
+  }
+
+  observer.phase_begin(gsaca_phase::phase_2);
+  sa[0] = n - 1;
+  sa[1] = 0;
+  #pragma omp parallel for num_threads(threads)
+  for (size_t t = 0; t < threads; ++t) {
+    size_t const chunk = n / threads + (n % threads > 0);
+    uint64_t const begin = std::max((size_t) 2, t * chunk);
+    uint64_t const end = std::min(n, (t + 1) * chunk);
+    if (begin >= end) continue;
+    size_t j = std::upper_bound(offsets, offsets + l + 1, begin) -
+               offsets - 1;
+    for (uint64_t out = begin; out < end; ++j) {
+      if (gsaca_unlikely(observer.stop_requested())) break;
+      uint64_t const chain_end = std::min(end, offsets[j + 1]);
+      // text position of the output at out (suffix i of x is at i + 1)
+      uint64_t pos = order[j] + 1 - (out - offsets[j]) * p;
+      for (; out < chain_end; ++out, pos -= p) sa[out] = pos;
+    }
+  }
+  if (!observer.stop_requested()) observer.phase_2_progress(sa, n);
+  observer.phase_end(gsaca_phase::phase_2);
+  free(offsets);
+  free(order);
+}
+
+}
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <queue>
+#include <vector>
+#include "sequential/gsaca-ds.hpp"
+#include "parallel/gsaca-ds-par.hpp"
+#include "hash.hpp"
+#include "lcp.hpp"
+
+namespace gsaca_lyndon {
+
+// Prefix-free parsing (PFP): BWT and suffix array samples of a (repetitive)
+// text from a dictionary of phrases and the parse of the text into phrase
+// ids, without a suffix array of the text. The text uses the usual
+// sentinels; it is only scanned to build the parse and the dictionary (it
+// can be memory mapped), the memory is proportional to the parse and the
+// dictionary.
+//
+// Windows of w symbols whose Karp-Rabin hash is divisible by the trigger
+// modulus are trigger strings. The window at position 0 and the final
+// window (the final sentinel followed by w - 1 padding zeros) are triggers,
+// windows containing a sentinel otherwise are not. A phrase reaches from one
+// trigger to the end of the next one, thus consecutive phrases overlap by w
+// symbols, and phrases contain triggers only at their ends. Hence the
+// suffixes of length more than w of dictionary phrases are prefix free: the
+// suffix of the text at position i is ordered by the phrase suffix from i
+// to the end of its phrase, and equal phrase suffixes are ordered by the
+// rank of the parse suffix of the next phrase. The parse is sorted by
+// gsaca_ds on 32-bit phrase ids (ranks of the phrases in lexicographic
+// order), so is the dictionary. For every phrase, the ranks of the parse
+// suffixes behind its occurrences are listed in increasing order, so a
+// group of equal phrase suffixes is emitted in one piece if all of them are
+// preceded by the same symbol, and otherwise by merging these lists.
+//
+// The BWT is reported in runs, run_sink(symbol, length), following the
+// convention bwt[i] = text[sa[i] - 1] and text[n - 1] for sa[i] = 0. For
+// the first and the last position of every run, sample_sink(position,
+// sa[position], is_run_start) is called (both for runs of length one).
+struct pfp_config {
+  size_t window = 10;
+  uint64_t trigger_modulus = 100;
+  size_t threads = 1;
+};
+
+struct pfp_stats {
+  uint64_t phrases = 0;
+  uint64_t dictionary_phrases = 0;
+  uint64_t dictionary_symbols = 0;
+  uint64_t runs = 0;
+};
+
+namespace pfp_internal {
+
+constexpr uint64_t kr_prime = 1999999973ULL;
+constexpr uint64_t kr_base = 256;
+
+// Start positions of the triggers, including 0 and n - 1.
+template<typename value_type>
+static std::vector<uint64_t> triggers(value_type const *const text,
+                                      size_t const n, size_t const w,
+                                      uint64_t const modulus,
+                                      size_t const threads) {
+  std::vector<uint64_t> result{0};
+  // windows inside the text without the sentinels start in [1, last)
+  uint64_t const last = (n >= w + 2) ? (n - w) : 1;
+  uint64_t power = 1;
+  for (size_t i = 1; i < w; ++i) power = (power * kr_base) % kr_prime;
+
+  std::vector<std::vector<uint64_t>> found(threads);
+  #pragma omp parallel for num_threads(threads) schedule(static, 1)
+  for (size_t t = 0; t < threads; ++t) {
+    uint64_t const begin = 1 + (last - 1) * t / threads;
+    uint64_t const end = 1 + (last - 1) * (t + 1) / threads;
+    if (begin >= end) continue;
+    uint64_t h = 0;
+    for (size_t i = 0; i < w; ++i) {
+      h = (h * kr_base + (uint64_t) text[begin + i] % kr_prime) % kr_prime;
+    }
+    for (uint64_t s = begin;; ++s) {
+      if (h % modulus == 0) found[t].push_back(s);
+      if (s + 1 == end) break;
+      uint64_t const out = ((uint64_t) text[s] % kr_prime) * power % kr_prime;
+      h = (h + kr_prime - out) % kr_prime;
+      h = (h * kr_base + (uint64_t) text[s + w] % kr_prime) % kr_prime;
+    }
+  }
+  for (auto const &part : found) {
+    result.insert(result.end(), part.begin(), part.end());
+  }
+  result.push_back(n - 1);
+  return result;
+}
+
+}
+
+template<typename value_type, typename run_sink_type,
+    typename sample_sink_type>
+static bool pfp_bwt(value_type const *const text, size_t const n,
+                    pfp_config const &config, run_sink_type run_sink,
+                    sample_sink_type sample_sink,
+                    pfp_stats *const stats = nullptr) {
+  static_assert(std::is_unsigned<value_type>::value);
+  size_t const w = config.window;
+  size_t const threads = std::max((size_t) 1, config.threads);
+  if (w == 0 || config.trigger_modulus == 0 || n < 2) return false;
+
+  // symbol at position i of the text padded with zeros
+  auto const at = [&](uint64_t const i) {
+      return (i < n) ? text[i] : (value_type) 0;
+  };
+
+  std::vector<uint64_t> const start = pfp_internal::triggers(
+      text, n, w, config.trigger_modulus, threads);
+  size_t const phrases = start.size() - 1;
+  auto const phrase_length = [&](uint64_t const k) {
+      return start[k + 1] + w - start[k];
+  };
+
+  // Dictionary: phrases with equal fingerprints are verified and numbered,
+  // then the distinct ones are copied and sorted. rep[d] is an occurrence of
+  // phrase d, id[k] the phrase of occurrence k.
+  std::vector<std::pair<uint64_t, uint64_t>> by_hash(phrases);
+  #pragma omp parallel for num_threads(threads)
+  for (uint64_t k = 0; k < phrases; ++k) {
+    uint64_t const length = phrase_length(k);
+    uint64_t const inside = std::min(length, n - start[k]);
+    by_hash[k] = {hash_bytes(text + start[k], inside * sizeof(value_type),
+                             length), k};
+  }
+  if (threads > 1) ips4o::parallel::sort(by_hash.begin(), by_hash.end(),
+                                         std::less<>(), threads);
+  else std::sort(by_hash.begin(), by_hash.end());
+
+  auto const equal_phrases = [&](uint64_t const a, uint64_t const b) {
+      uint64_t const length = phrase_length(a);
+      if (phrase_length(b) != length) return false;
+      for (uint64_t i = 0; i < length; ++i) {
+        if (at(start[a] + i) != at(start[b] + i)) return false;
+      }
+      return true;
+  };
+  std::vector<uint64_t> id(phrases);
+  std::vector<uint64_t> rep;
+  for (size_t i = 0; i < phrases;) {
+    size_t j = i;
+    size_t const first_id = rep.size();
+    while (j < phrases && by_hash[j].first == by_hash[i].first) {
+      uint64_t const k = by_hash[j].second;
+      // hash collisions: compare with the phrases of this hash so far
+      size_t d = first_id;
+      while (d < rep.size() && !equal_phrases(rep[d], k)) ++d;
+      if (d == rep.size()) rep.push_back(k);
+      id[k] = d;
+      ++j;
+    }
+    i = j;
+  }
+  std::vector<std::pair<uint64_t, uint64_t>>().swap(by_hash);
+  size_t const dictionary = rep.size();
+  if (dictionary >= (1ULL << 32) - 1) return false;
+
+  // the dictionary as one string (padding included), offsets per phrase
+  std::vector<uint64_t> offset(dictionary + 1, 0);
+  for (size_t d = 0; d < dictionary; ++d) {
+    offset[d + 1] = offset[d] + phrase_length(rep[d]);
+  }
+  std::vector<value_type> dict(offset[dictionary]);
+  #pragma omp parallel for num_threads(threads)
+  for (size_t d = 0; d < dictionary; ++d) {
+    for (uint64_t i = offset[d]; i < offset[d + 1]; ++i) {
+      dict[i] = at(start[rep[d]] + i - offset[d]);
+    }
+  }
+  // -1, 0 or 1 as dict[a, a_end) compares to dict[b, b_end)
+  auto const compare = [&](uint64_t a, uint64_t const a_end, uint64_t b,
+                           uint64_t const b_end) {
+      for (; a < a_end && b < b_end; ++a, ++b) {
+        if (dict[a] != dict[b]) return (dict[a] < dict[b]) ? -1 : 1;
+      }
+      return (a == a_end) ? ((b == b_end) ? 0 : -1) : 1;
+  };
+
+  // phrase ids are the lexicographic ranks (1-based, 0 is the sentinel)
+  std::vector<uint32_t> order(dictionary);
+  for (size_t d = 0; d < dictionary; ++d) order[d] = d;
+  auto const phrase_less = [&](uint32_t const a, uint32_t const b) {
+      return compare(offset[a], offset[a + 1], offset[b], offset[b + 1]) < 0;
+  };
+  if (threads > 1) ips4o::parallel::sort(order.begin(), order.end(),
+                                         phrase_less, threads);
+  else std::sort(order.begin(), order.end(), phrase_less);
+  std::vector<uint32_t> rank(dictionary);
+  for (size_t r = 0; r < dictionary; ++r) rank[order[r]] = r + 1;
+
+  // parse with sentinels, suffix sorted with the integer alphabet engine
+  std::vector<uint32_t> parse(phrases + 2, 0);
+  #pragma omp parallel for num_threads(threads)
+  for (uint64_t k = 0; k < phrases; ++k) parse[k + 1] = rank[id[k]];
+  std::vector<uint64_t>().swap(id);
+  std::vector<uint64_t> parse_sa(phrases + 2);
+  if (threads > 1) gsaca_ds_par(parse.data(), parse_sa.data(), phrases + 2,
+                                threads);
+  else gsaca_ds(parse.data(), parse_sa.data(), phrases + 2);
+
+  // For every phrase (by id), the ranks of the parse suffixes behind its
+  // occurrences, in increasing order. The parse suffix at j follows the
+  // occurrence j - 2 of phrase parse[j - 1] (parse starts with a sentinel).
+  std::vector<uint64_t> list_begin(dictionary + 2, 0);
+  for (uint64_t k = 0; k < phrases; ++k) ++list_begin[parse[k + 1] + 1];
+  for (size_t d = 1; d < dictionary + 2; ++d) {
+    list_begin[d] += list_begin[d - 1];
+  }
+  std::vector<uint64_t> list(phrases);
+  {
+    std::vector<uint64_t> fill(list_begin.begin(), list_begin.end() - 1);
+    for (uint64_t r = 0; r < phrases + 2; ++r) {
+      uint64_t const j = parse_sa[r];
+      if (j >= 2) list[fill[parse[j - 1]]++] = r;
+    }
+  }
+
+  // All phrase suffixes longer than w, as (rank of phrase, offset), sorted
+  // by the suffix array of the dictionary in rank order. Symbols are shifted
+  // by two, every phrase ends with a one, thus a phrase suffix is smaller
+  // than the phrase suffixes it is a proper prefix of, and equal phrase
+  // suffixes are adjacent. The LCP array (matching stops at the ones) tells
+  // where the groups of equal phrase suffixes start.
+  using dict_symbol = std::conditional_t<(sizeof(value_type) == 1), uint16_t,
+      std::conditional_t<(sizeof(value_type) < 4), uint32_t, uint64_t>>;
+  std::vector<uint64_t> dict_start(dictionary + 1);
+  std::vector<dict_symbol> dict_text(dict.size() + dictionary + 2, 0);
+  std::vector<uint32_t> rank_at(dict_text.size());
+  dict_start[0] = 1;
+  for (size_t r = 0; r < dictionary; ++r) {
+    uint32_t const d = order[r];
+    dict_start[r + 1] = dict_start[r] + offset[d + 1] - offset[d] + 1;
+  }
+  #pragma omp parallel for num_threads(threads)
+  for (size_t r = 0; r < dictionary; ++r) {
+    uint32_t const d = order[r];
+    uint64_t p = dict_start[r];
+    for (uint64_t i = offset[d]; i < offset[d + 1]; ++i) {
+      rank_at[p] = r;
+      dict_text[p++] = (dict_symbol) dict[i] + 2;
+    }
+    rank_at[p] = r;
+    dict_text[p] = 1;
+  }
+  std::vector<uint64_t> dict_sa(dict_text.size());
+  std::vector<uint64_t> dict_plcp(dict_text.size());
+  if (threads > 1) {
+    gsaca_ds_par(dict_text.data(), dict_sa.data(), dict_text.size(), threads);
+  } else {
+    gsaca_ds(dict_text.data(), dict_sa.data(), dict_text.size());
+  }
+  plcp_by_phi_parallel(dict_text.data(), dict_sa.data(), dict_plcp.data(),
+                       dict_text.size(), threads, (dict_symbol) 1);
+  std::vector<dict_symbol>().swap(dict_text);
+
+  std::vector<std::pair<uint32_t, uint32_t>> suffixes;
+  std::vector<bool> group_start;
+  uint64_t previous_length = 0;
+  uint64_t min_lcp = 0;
+  for (uint64_t const p : dict_sa) {
+    min_lcp = std::min(min_lcp, dict_plcp[p]);
+    if (p == 0 || p + 1 >= dict_sa.size()) continue;
+    uint64_t const r = rank_at[p];
+    uint64_t const o = p - dict_start[r];
+    uint64_t const length = dict_start[r + 1] - dict_start[r] - 1 - o;
+    // skips the phrase separators as well
+    if (length > w) {
+      suffixes.emplace_back(r + 1, o);
+      group_start.push_back(suffixes.size() == 1 || length != min_lcp ||
+                            length != previous_length);
+      previous_length = length;
+      min_lcp = UINT64_MAX;
+    }
+  }
+  std::vector<uint64_t>().swap(dict_sa);
+  std::vector<uint64_t>().swap(dict_plcp);
+  std::vector<uint32_t>().swap(rank_at);
+
+  // A position of the BWT is given by the rank of the parse suffix behind
+  // its phrase occurrence and the offset in the phrase, the suffix array
+  // entry is only computed for run boundaries (rank UINT64_MAX: the offset
+  // is the entry).
+  auto const sa_value = [&](uint64_t const r, uint64_t const o) {
+      return (r == UINT64_MAX) ? o : start[parse_sa[r] - 2] + o;
+  };
+
+  // runs of the BWT, with samples at their first and last position
+  uint64_t position = 0;
+  uint64_t runs = 0;
+  value_type run_symbol = 0;
+  uint64_t run_length = 0;
+  uint64_t last_rank = 0, last_offset = 0;
+  auto const emit = [&](value_type const symbol, uint64_t const count,
+                        uint64_t const first_rank, uint64_t const first_offset,
+                        uint64_t const rank, uint64_t const offset) {
+      if (run_length > 0 && symbol == run_symbol) {
+        run_length += count;
+      } else {
+        if (run_length > 0) {
+          run_sink(run_symbol, run_length);
+          sample_sink(position - 1, sa_value(last_rank, last_offset), false);
+        }
+        sample_sink(position, sa_value(first_rank, first_offset), true);
+        run_symbol = symbol;
+        run_length = count;
+        ++runs;
+      }
+      last_rank = rank;
+      last_offset = offset;
+      position += count;
+  };
+
+  // the final sentinel
+  emit(text[n - 2], 1, UINT64_MAX, n - 1, UINT64_MAX, n - 1);
+
+  // symbol in front of the phrase occurrence whose next parse suffix has
+  // rank r, at offset o in the phrase d
+  auto const preceding = [&](uint32_t const d, uint64_t const o,
+                             uint64_t const r) {
+      if (o > 0) return dict[offset[d] + o - 1];
+      uint64_t const k = parse_sa[r] - 2;
+      if (k == 0) return text[n - 1];
+      uint32_t const previous = order[parse[k] - 1];
+      return dict[offset[previous + 1] - w - 1];
+  };
+
+  using list_cursor = std::pair<uint64_t, size_t>; // (rank, member)
+  std::priority_queue<list_cursor, std::vector<list_cursor>,
+      std::greater<>> heap;
+  std::vector<uint64_t> cursor;
+  for (size_t i = 0; i < suffixes.size();) {
+    size_t j = i + 1;
+    while (j < suffixes.size() && !group_start[j]) ++j;
+    // the group suffixes[i, j) of equal phrase suffixes
+    uint32_t const d = order[suffixes[i].first - 1];
+    uint64_t const o = suffixes[i].second;
+    bool same = true;
+    for (size_t s = i; s < j && same; ++s) {
+      same = suffixes[s].second > 0 &&
+             preceding(order[suffixes[s].first - 1], suffixes[s].second, 0) ==
+             preceding(d, o, 0);
+    }
+    if (same) {
+      uint64_t count = 0;
+      uint64_t first = UINT64_MAX, last = 0;
+      uint64_t first_offset = 0, last_offset = 0;
+      for (size_t s = i; s < j; ++s) {
+        uint64_t const b = list_begin[suffixes[s].first];
+        uint64_t const e = list_begin[suffixes[s].first + 1];
+        count += e - b;
+        if (list[b] < first) {
+          first = list[b];
+          first_offset = suffixes[s].second;
+        }
+        if (list[e - 1] >= last) {
+          last = list[e - 1];
+          last_offset = suffixes[s].second;
+        }
+      }
+      emit(preceding(d, o, 0), count, first, first_offset, last, last_offset);
+    } else {
+      cursor.resize(j - i);
+      for (size_t s = i; s < j; ++s) {
+        cursor[s - i] = list_begin[suffixes[s].first];
+        heap.emplace(list[cursor[s - i]], s - i);
+      }
+      while (!heap.empty()) {
+        uint64_t const r = heap.top().first;
+        size_t const member = heap.top().second;
+        heap.pop();
+        auto const &suffix = suffixes[i + member];
+        emit(preceding(order[suffix.first - 1], suffix.second, r), 1, r,
+             suffix.second, r, suffix.second);
+        if (++cursor[member] < list_begin[suffix.first + 1]) {
+          heap.emplace(list[cursor[member]], member);
+        }
+      }
+    }
+    i = j;
+  }
+  run_sink(run_symbol, run_length);
+  sample_sink(position - 1, sa_value(last_rank, last_offset), false);
+
+  if (stats != nullptr) {
+    stats->phrases = phrases;
+    stats->dictionary_phrases = dictionary;
+    stats->dictionary_symbols = dict.size();
+    stats->runs = runs;
+  }
+  return position == n;
+}
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include "macros.hpp"
 
 namespace gsaca_lyndon {
 
@@ -25,5 +28,35 @@ struct phase_2_group_type {
   buffer_type size;
 };
 
+enum class gsaca_phase : uint32_t {
+  sort_by_prefix = 0,
+  phase_1 = 1,
+  phase_2 = 2
+};
+
+constexpr size_t gsaca_phase_count = 3;
+
+// Observes the construction. The engines report the boundaries of the
+// initial sorting by prefix, phase 1 and phase 2. Phase 1 reports how many
+// suffixes have been assigned to their final phase 1 group, phase 2 reports
+// the border up to which the suffix array is final (and free of flags). Both phases check
+// stop_requested at group boundaries and return early once it is true,
+// leaving the suffix array in an unspecified state. Custom observers derive
+// from no_observer and hide the members they need.
+struct no_observer {
+  gsaca_always_inline void phase_begin(gsaca_phase const) {}
+
+  gsaca_always_inline void phase_end(gsaca_phase const) {}
+
+  gsaca_always_inline void phase_1_progress(size_t const, size_t const) {}
+
+  template<typename index_type>
+  gsaca_always_inline void phase_2_progress(index_type const *const,
+                                            size_t const) {}
+
+  gsaca_always_inline bool stop_requested() const {
+    return false;
+  }
+};
 
 }
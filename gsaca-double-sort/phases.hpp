@@ -0,0 +1,166 @@
+#pragma once
+
+#include "sequential/gsaca-ds.hpp"
+#include "parallel/gsaca-ds-par.hpp"
+
+namespace gsaca_lyndon {
+
+// The three stages of gsaca_ds as separate calls, so that they can be
+// replaced, cached or interleaved with other work. The text uses the usual
+// sentinels (text[0] = text[n - 1] = 0, no other zeros). All stages of one
+// construction use the same index type, buffer type and flag policy F:
+//
+// sort_by_prefix: writes sa and returns the initial groups (see
+//   check_initial_groups for the contract of custom groups). With
+//   flag_type_bitset, the entries of sa carry flags (the flags have to fit,
+//   see flag_bits_fit). With flag_type_side, flag_type_side::build creates
+//   the bitvector, which has to live until phase_2 returns.
+//
+// phase_1: consumes the initial groups (the stack is empty afterwards) and
+//   rearranges sa. Returns the phase 2 groups in suffix array order; groups
+//   0 and 1 are the sentinels n - 1 and 0, the sizes add up to n. isa must
+//   have room for n entries, its content is ignored and overwritten.
+//
+// phase_2: takes sa and the groups as returned by phase_1 and writes the
+//   final suffix array to sa. isa must have room for n entries, its content
+//   is ignored and unspecified afterwards (not the inverse suffix array).
+//
+// Stages may run with different thread counts and sorters. Between stages,
+// the state (sa and the groups) can be stored and restored as raw memory.
+namespace phases {
+
+template<typename index_type>
+using buffer_type = get_buffer_type<auto_buffer_type, index_type>;
+
+template<typename index_type>
+using initial_groups = phase_1_stack_type<buffer_type<index_type>>;
+
+template<typename index_type>
+using phase_2_groups =
+    std::vector<phase_2_group_type<buffer_type<index_type>>>;
+
+// Initial groups: all suffixes with the same prefix of length prefix (shorter
+// at the end of the text), in lexicographic order.
+template<typename F = flag_type<false>, typename index_type,
+    typename value_type>
+static initial_groups<index_type>
+sort_by_prefix(value_type const *const text, index_type *const sa,
+               size_t const n, uint8_t const prefix = 1) {
+  return double_sort_internal::sort_by_prefix<buffer_type<index_type>, F>(
+      text, sa, n, prefix);
+}
+
+template<typename F = flag_type<false>, typename index_type,
+    typename value_type>
+static initial_groups<index_type>
+sort_by_prefix_parallel(value_type const *const text, index_type *const sa,
+                        size_t const n, size_t const threads,
+                        uint8_t const prefix = 1) {
+  return double_sort_internal::sort_by_prefix_parallel<
+      buffer_type<index_type>, F>(text, sa, n, prefix, threads);
+}
+
+// Checks the contract of initial groups for the given prefix length:
+// sa[0] = n - 1 and sa[1] = 0; the groups are contiguous, non-empty and
+// cover sa[2, n) in order; each group has context 1, check_for_runs set and
+// is_final unset; within a group the suffixes share their prefix and are
+// ordered by increasing position; the prefixes of consecutive groups
+// increase.
+template<typename F = flag_type<false>, typename index_type,
+    typename value_type>
+static bool check_initial_groups(value_type const *const text,
+                                 index_type const *const sa, size_t const n,
+                                 initial_groups<index_type> const &groups,
+                                 size_t const prefix) {
+  if (n < 3 || (uint64_t) sa[0] != n - 1 ||
+      (uint64_t) F::remove_flag(sa[1]) != 0) {
+    return false;
+  }
+  // -1, 0 or 1 as the prefix of the suffix at a compares to the one at b
+  auto const compare = [&](uint64_t const a, uint64_t const b) {
+      for (size_t k = 0; k < prefix; ++k) {
+        if (text[a + k] != text[b + k]) {
+          return (text[a + k] < text[b + k]) ? -1 : 1;
+        }
+        if (text[a + k] == 0) break;
+      }
+      return 0;
+  };
+  uint64_t border = 2;
+  uint64_t previous = 0;
+  for (auto const &group : groups) {
+    if ((uint64_t) group.start != border || group.size == 0 ||
+        (uint64_t) group.context != 1 || !group.check_for_runs ||
+        group.is_final || border + group.size > n) {
+      return false;
+    }
+    uint64_t const first = F::remove_flag(sa[border]);
+    if (first == 0 || first >= n - 1 ||
+        (border > 2 && compare(previous, first) >= 0)) {
+      return false;
+    }
+    for (uint64_t i = border + 1; i < border + group.size; ++i) {
+      uint64_t const current = F::remove_flag(sa[i]);
+      if (current >= n - 1 ||
+          current <= (uint64_t) F::remove_flag(sa[i - 1]) ||
+          compare(first, current) != 0) {
+        return false;
+      }
+    }
+    previous = first;
+    border += group.size;
+  }
+  return border == n;
+}
+
+template<typename p1_sorter = MSD, typename F = flag_type<false>,
+    typename index_type, typename observer_type = no_observer>
+static phase_2_groups<index_type>
+phase_1(index_type *const sa, buffer_type<index_type> *const isa,
+        initial_groups<index_type> &groups,
+        observer_type observer = observer_type()) {
+  return phase_1_by_sorting<p1_sorter, F>(sa, isa, groups, observer);
+}
+
+template<typename F = flag_type<false>, typename index_type,
+    typename observer_type = no_observer>
+static phase_2_groups<index_type>
+phase_1_parallel(index_type *const sa, buffer_type<index_type> *const isa,
+                 initial_groups<index_type> &groups, size_t const threads,
+                 observer_type observer = observer_type()) {
+  return phase_1_by_sorting_parallel<F>(sa, isa, groups, threads, 0,
+                                        observer);
+}
+
+// Phase 2 reads the rank of the sentinel n - 1 when a suffix is induced by
+// it. The engines keep it from phase 1, here it is set explicitly so that
+// isa does not have to survive between the phases.
+template<typename p2_sorter = MSD, typename F = flag_type<false>,
+    typename index_type, typename observer_type = no_observer>
+static void phase_2(index_type *const sa, buffer_type<index_type> *const isa,
+                    size_t const n, phase_2_groups<index_type> const &groups,
+                    observer_type observer = observer_type(),
+                    F const flags = F()) {
+  isa[n - 1] = 0;
+  phase_2_by_sorting<p2_sorter, F>(sa, isa, n, groups.data(), groups.size(),
+                                   observer, flags);
+}
+
+template<typename F = flag_type<false>, typename index_type,
+    typename observer_type = no_observer>
+static void phase_2_parallel(index_type *const sa,
+                             buffer_type<index_type> *const isa,
+                             size_t const n,
+                             phase_2_groups<index_type> const &groups,
+                             size_t const threads,
+                             observer_type observer = observer_type(),
+                             F const flags = F()) {
+  isa[n - 1] = 0;
+  phase_2_by_sorting_stable_parallel<F>(sa, isa, n, groups.data(),
+                                        groups.size(), threads, observer,
+                                        flags);
+}
+
+}
+
+}
@@ -2,14 +2,15 @@
 
 #include <limits>
 #include "uint_types.hpp"
+#include "sorter_tuning.hpp"
 #include "ips4o/ips4o.hpp"
 
 namespace gsaca_lyndon {
 
 namespace radix_internal {
 
-// this seems to work best
-constexpr size_t insertion_threshold = 32;
+// this seems to work best (re-tune with benchmark/sorters)
+constexpr size_t insertion_threshold = sorter_tuning::insertion_threshold;
 
 template<typename data_type>
 using key_type = typename std::remove_reference<
@@ -217,8 +218,11 @@ msd_radix(data_type *const data, data_type *const buffer, size_t const n,
   radix_internal::msd_radix_internal<increasing>(data, buffer, n, key_bytes);
 }
 
+// The flag policy tells stable sorters how to compare values that may carry
+// a flag (see flag_type); radix sorts are stable anyway and ignore it.
 struct MSD {
-  template<bool increasing = true, bool stable = true, typename data_type>
+  template<bool increasing = true, bool stable = true,
+      typename F = flag_type<false>, typename data_type>
   static inline void
   sort(data_type *const data, data_type *const buffer, size_t const n,
        size_t const max_key = radix_internal::key_max<data_type>) {
@@ -231,7 +235,8 @@ struct MSD {
 };
 
 struct LSD {
-  template<bool increasing = true, bool stable = true, typename data_type>
+  template<bool increasing = true, bool stable = true,
+      typename F = flag_type<false>, typename data_type>
   static inline void
   sort(data_type *const data, data_type *const buffer, size_t const n,
        size_t const max_key = radix_internal::key_max<data_type>) {
@@ -244,20 +249,25 @@ struct LSD {
 };
 
 struct IPS4O {
-  template<bool increasing = true, bool stable = false, typename data_type>
+  template<bool increasing = true, bool stable = false,
+      typename F = flag_type<false>, typename data_type>
   static inline void
   sort(data_type *const data, data_type *const, size_t const n,
        size_t const = 0) {
     auto compare = [&](data_type const &a, data_type const &b) {
         if constexpr (increasing) {
           if constexpr (stable) {
-            return a.key < b.key || (a.key == b.key && a.value < b.value);
+            return a.key < b.key || (a.key == b.key &&
+                                     F::remove_flag(a.value) <
+                                     F::remove_flag(b.value));
           } else {
             return a.key < b.key;
           }
         } else {
           if constexpr (stable) {
-            return a.key > b.key || (a.key == b.key && a.value < b.value);
+            return a.key > b.key || (a.key == b.key &&
+                                     F::remove_flag(a.value) <
+                                     F::remove_flag(b.value));
           } else {
             return a.key > b.key;
           }
@@ -272,6 +282,32 @@ struct IPS4O {
   }
 };
 
+// Chooses MSD, LSD or IPS4O per call, based on the group size and the number
+// of key bytes (see sorter_tuning.hpp). IPS4O is only used if no stable sort
+// is required.
+struct TUNED {
+  template<bool increasing = true, bool stable = true,
+      typename F = flag_type<false>, typename data_type>
+  static inline void
+  sort(data_type *const data, data_type *const buffer, size_t const n,
+       size_t const max_key = radix_internal::key_max<data_type>) {
+    uint8_t const key_bytes = (71 - __builtin_clzl(max_key)) >> 3;
+    if (!stable && n >= sorter_tuning::ips4o_min_size[key_bytes]) {
+      IPS4O::template sort<increasing, false, F>(data, buffer, n, max_key);
+    } else if (n >= sorter_tuning::lsd_min_size[key_bytes]) {
+      radix_internal::lsd_radix_internal<increasing>(data, buffer, n,
+                                                     key_bytes);
+    } else {
+      radix_internal::msd_radix_internal<increasing>(data, buffer, n,
+                                                     key_bytes);
+    }
+  }
+
+  static std::string id() {
+    return "tuned";
+  }
+};
+
 template<typename key_type, typename value_type = key_type>
 struct radix_key_val_pair {
   key_type key;
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "sequential/gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+// Suffix sorting of run-length encoded texts. The text consists of runs
+// (symbols[k], lengths[k]) for k < runs, surrounded by the usual sentinels,
+// i.e. its length is n = 2 + sum of lengths and the first run starts at
+// position 1. Symbols must be nonzero; adjacent runs of equal symbols and
+// empty runs are allowed (they are merged or skipped).
+//
+// Let a run of symbol c be followed by symbol d (or by the final sentinel,
+// then d = 0). Its suffixes c^a X (X starting with d) compare to all other
+// suffixes starting with c by the following rules: runs with d < c come
+// before runs with d > c; for d < c shorter c^a are smaller, for d > c longer
+// c^a are smaller; equal c^a are ordered by X. Thus, only the suffixes
+// starting at run heads need to be sorted. They are sorted by gsaca_ds on the
+// text of runs, where each run is renamed to the rank of (c, d > c, a or -a).
+// Afterwards, the suffixes inside runs are generated level by level (by a) in
+// the order of their run heads, without decompressing the text.
+
+template<typename value_type>
+struct rl_bwt_run {
+  value_type symbol;
+  uint64_t length;
+  uint64_t sa; // suffix array value at the first position of the run
+};
+
+namespace rle_internal {
+
+template<typename value_type>
+struct run_list {
+  std::vector<value_type> symbol;
+  std::vector<uint64_t> length;
+  std::vector<uint64_t> start; // text position of the first symbol
+  std::vector<uint8_t> up; // is the next symbol larger?
+  uint64_t n;
+
+  size_t size() const {
+    return symbol.size();
+  }
+
+  // symbol in front of the run (0 for the first run)
+  value_type previous(uint64_t const k) const {
+    return (k > 0) ? symbol[k - 1] : 0;
+  }
+
+  // position of the suffix c^a X of run k
+  uint64_t position(uint64_t const k, uint64_t const a) const {
+    return start[k] + length[k] - a;
+  }
+};
+
+template<typename value_type>
+static run_list<value_type> normalize(value_type const *const symbols,
+                                      uint64_t const *const lengths,
+                                      size_t const runs) {
+  run_list<value_type> result;
+  uint64_t position = 1;
+  for (size_t k = 0; k < runs; ++k) {
+    if (lengths[k] == 0) continue;
+    if (result.size() > 0 && result.symbol.back() == symbols[k]) {
+      result.length.back() += lengths[k];
+    } else {
+      result.symbol.push_back(symbols[k]);
+      result.length.push_back(lengths[k]);
+      result.start.push_back(position);
+    }
+    position += lengths[k];
+  }
+  result.n = position + 1;
+  size_t const r = result.size();
+  result.up.resize(r);
+  for (size_t k = 0; k + 1 < r; ++k) {
+    result.up[k] = result.symbol[k + 1] > result.symbol[k];
+  }
+  return result;
+}
+
+// sorts the run heads with gsaca_ds on the renamed text of runs
+template<typename name_type, typename value_type>
+static std::vector<uint64_t> sort_heads(run_list<value_type> const &runs) {
+  size_t const r = runs.size();
+  std::vector<uint64_t> by_key(r);
+  for (size_t k = 0; k < r; ++k) by_key[k] = k;
+  auto const key_less = [&](uint64_t const a, uint64_t const b) {
+      if (runs.symbol[a] != runs.symbol[b])
+        return runs.symbol[a] < runs.symbol[b];
+      if (runs.up[a] != runs.up[b]) return runs.up[a] < runs.up[b];
+      return runs.up[a] ? runs.length[a] > runs.length[b]
+                        : runs.length[a] < runs.length[b];
+  };
+  std::sort(by_key.begin(), by_key.end(), key_less);
+
+  std::vector<name_type> renamed(r + 2);
+  name_type name = 0;
+  for (size_t i = 0; i < r; ++i) {
+    if (i == 0 || key_less(by_key[i - 1], by_key[i])) ++name;
+    renamed[by_key[i] + 1] = name;
+  }
+  renamed[0] = renamed[r + 1] = 0;
+
+  std::vector<uint64_t> heads(r);
+  if (r < 4) {
+    // too short for gsaca_ds; the shorter suffix is smaller if it is a prefix
+    for (size_t k = 0; k < r; ++k) heads[k] = k;
+    std::sort(heads.begin(), heads.end(),
+              [&](uint64_t const a, uint64_t const b) {
+                  return std::lexicographical_compare(
+                      renamed.begin() + a + 1, renamed.end() - 1,
+                      renamed.begin() + b + 1, renamed.end() - 1);
+              });
+  } else {
+    std::vector<name_type> sa(r + 2);
+    gsaca_ds<MSD, MSD>(renamed.data(), sa.data(), r + 2, 1);
+    for (size_t i = 0; i < r; ++i) heads[i] = (uint64_t) sa[i + 2] - 1;
+  }
+  return heads;
+}
+
+// Groups the runs by (symbol, up). Within a group, runs are ordered by the
+// suffix that follows them. Returns the runs and the group borders.
+template<typename value_type>
+static std::pair<std::vector<uint64_t>, std::vector<uint64_t>>
+group_runs(run_list<value_type> const &runs) {
+  size_t const r = runs.size();
+  std::vector<uint64_t> order;
+  order.reserve(r);
+  if (r > 0) order.push_back(r - 1); // followed by the final sentinel
+  auto const heads = (r + 2 < (1ULL << 32)) ? sort_heads<uint32_t>(runs)
+                                            : sort_heads<uint64_t>(runs);
+  for (uint64_t const head : heads) {
+    if (head > 0) order.push_back(head - 1);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint64_t const a, uint64_t const b) {
+                       return (runs.symbol[a] != runs.symbol[b])
+                              ? runs.symbol[a] < runs.symbol[b]
+                              : runs.up[a] < runs.up[b];
+                   });
+  std::vector<uint64_t> borders = {0};
+  for (size_t i = 1; i <= r; ++i) {
+    if (i == r || runs.symbol[order[i - 1]] != runs.symbol[order[i]] ||
+        runs.up[order[i - 1]] != runs.up[order[i]]) {
+      borders.push_back(i);
+    }
+  }
+  return {order, borders};
+}
+
+// Fenwick tree over the runs of one group that are active on a level
+class active_set {
+public:
+  explicit active_set(size_t const size) : tree_(size + 1, 0) {}
+
+  void add(size_t i, int64_t const delta) {
+    for (++i; i < tree_.size(); i += i & (0 - i)) tree_[i] += delta;
+  }
+
+  // number of active entries before i
+  uint64_t rank(size_t i) const {
+    int64_t result = 0;
+    for (; i > 0; i -= i & (0 - i)) result += tree_[i];
+    return result;
+  }
+
+  // index of the active entry with the given rank
+  size_t select(uint64_t rank) const {
+    size_t pos = 0;
+    size_t step = 1;
+    while (2 * step < tree_.size()) step *= 2;
+    for (; step > 0; step /= 2) {
+      if (pos + step < tree_.size() && (uint64_t) tree_[pos + step] <= rank) {
+        pos += step;
+        rank -= tree_[pos];
+      }
+    }
+    return pos;
+  }
+
+private:
+  std::vector<int64_t> tree_;
+};
+
+}
+
+// Writes the suffix array (n entries, see above) of a run-length encoded text.
+// Apart from the output, memory is linear in the number of runs.
+template<typename index_type, typename value_type>
+static void rle_gsaca_ds(value_type const *const symbols,
+                         uint64_t const *const lengths, size_t const runs,
+                         index_type *const sa) {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+  auto const list = rle_internal::normalize(symbols, lengths, runs);
+  auto const grouping = rle_internal::group_runs(list);
+  auto const &order = grouping.first;
+  auto const &borders = grouping.second;
+
+  uint64_t out = 0;
+  sa[out++] = list.n - 1;
+  sa[out++] = 0;
+  std::vector<uint64_t> active;
+  for (size_t g = 0; g + 1 < borders.size(); ++g) {
+    active.assign(order.begin() + borders[g], order.begin() + borders[g + 1]);
+    bool const up = list.up[active[0]];
+    uint64_t total = 0;
+    for (uint64_t const k : active) total += list.length[k];
+
+    // levels a = 1, 2, ...; for up groups, level a is written behind the
+    // S(a) = sum of max(0, length - a) entries of the higher levels
+    uint64_t const base = out;
+    uint64_t skip = total - active.size();
+    for (uint64_t a = 1; !active.empty(); ++a) {
+      uint64_t level_out = up ? base + skip : out;
+      size_t kept = 0;
+      for (uint64_t const k : active) {
+        sa[level_out++] = list.position(k, a);
+        if (list.length[k] > a) active[kept++] = k;
+      }
+      active.resize(kept);
+      if (!up) out = level_out;
+      skip -= kept;
+    }
+    out = base + total;
+  }
+}
+
+// Computes the run-length encoded BWT of a run-length encoded text, together
+// with the suffix array value at the first position of each BWT run. Time is
+// O(r log r) and memory is O(r) for r text runs, independent of n.
+template<typename value_type>
+static std::vector<rl_bwt_run<value_type>>
+rle_bwt(value_type const *const symbols, uint64_t const *const lengths,
+        size_t const runs) {
+  static_assert(std::is_unsigned<value_type>::value);
+  auto const list = rle_internal::normalize(symbols, lengths, runs);
+  auto const grouping = rle_internal::group_runs(list);
+  auto const &order = grouping.first;
+  auto const &borders = grouping.second;
+
+  std::vector<rl_bwt_run<value_type>> result;
+  auto const emit = [&](value_type const symbol, uint64_t const length,
+                        uint64_t const sa) {
+      if (length == 0) return;
+      if (!result.empty() && result.back().symbol == symbol) {
+        result.back().length += length;
+      } else {
+        result.push_back(rl_bwt_run<value_type>{symbol, length, sa});
+      }
+  };
+  emit(list.size() > 0 ? list.symbol.back() : 0, 1, list.n - 1);
+  emit(0, 1, 0);
+
+  for (size_t g = 0; g + 1 < borders.size(); ++g) {
+    uint64_t const *const group = order.data() + borders[g];
+    size_t const size = borders[g + 1] - borders[g];
+    value_type const c = list.symbol[group[0]];
+    bool const up = list.up[group[0]];
+
+    // group indices by run length (ties in group order)
+    std::vector<size_t> by_length(size);
+    for (size_t i = 0; i < size; ++i) by_length[i] = i;
+    std::stable_sort(by_length.begin(), by_length.end(),
+                     [&](size_t const a, size_t const b) {
+                         return list.length[group[a]] <
+                                list.length[group[b]];
+                     });
+
+    rle_internal::active_set set(size);
+    uint64_t active = 0;
+    // c-entries of the active runs on levels [from, to], to in level order
+    auto const emit_levels = [&](uint64_t const from, uint64_t const to) {
+        uint64_t const levels = up ? from - to + 1 : to - from + 1;
+        if (active == 0 || from == 0 || to == 0 ||
+            (up ? from < to : from > to)) return;
+        emit(c, active * levels, list.position(group[set.select(0)], from));
+    };
+    // one level: runs of length a end here, their entries have the symbol in
+    // front of the run, all others have c
+    auto const emit_ending = [&](size_t const begin, size_t const end,
+                                 uint64_t const a) {
+        uint64_t done = 0;
+        for (size_t j = begin; j < end; ++j) {
+          size_t const i = by_length[j];
+          uint64_t const rank = set.rank(i);
+          if (rank > done) {
+            emit(c, rank - done, list.position(group[set.select(done)], a));
+          }
+          emit(list.previous(group[i]), 1, list.start[group[i]]);
+          done = rank + 1;
+        }
+        if (active > done) {
+          emit(c, active - done, list.position(group[set.select(done)], a));
+        }
+    };
+
+    if (!up) {
+      for (size_t i = 0; i < size; ++i) set.add(i, 1);
+      active = size;
+      uint64_t a = 1;
+      for (size_t j = 0; j < size;) {
+        uint64_t const length = list.length[group[by_length[j]]];
+        size_t end = j;
+        while (end < size && list.length[group[by_length[end]]] == length) {
+          ++end;
+        }
+        emit_levels(a, length - 1);
+        emit_ending(j, end, length);
+        for (size_t e = j; e < end; ++e) set.add(by_length[e], -1);
+        active -= end - j;
+        a = length + 1;
+        j = end;
+      }
+    } else {
+      for (size_t j = size; j > 0;) {
+        uint64_t const length = list.length[group[by_length[j - 1]]];
+        size_t begin = j;
+        while (begin > 0 &&
+               list.length[group[by_length[begin - 1]]] == length) {
+          --begin;
+        }
+        for (size_t e = begin; e < j; ++e) set.add(by_length[e], 1);
+        active += j - begin;
+        emit_ending(begin, j, length);
+        uint64_t const next = (begin > 0)
+            ? list.length[group[by_length[begin - 1]]] : 0;
+        emit_levels(length - 1, next + 1);
+        j = begin;
+      }
+    }
+  }
+  return result;
+}
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include "index_file.hpp"
+
+namespace gsaca_lyndon {
+
+// Content-addressed on-disk cache of suffix arrays. Entries are index files
+// (see index_file.hpp) named after the fingerprint of the text, its length
+// and the index and symbol widths. A lookup costs one (parallel) hashing pass
+// over the text; on a hit the cached suffix array is mapped, on a miss it is
+// built, stored and the least recently used entries are evicted until the
+// cache fits into max_bytes. The modification time of an entry serves as its
+// last use, so the LRU order survives restarts and is shared by all
+// processes using the same directory. Entries are built under a temporary
+// name (entry.tmp.<pid>.<id>). Temporary files count against max_bytes; the
+// ones left behind by a writer that crashed are removed on eviction, as soon
+// as their process has exited or, if that cannot be told (e.g. a directory
+// shared by several hosts), once they have not been written for
+// stale_tmp_age.
+class sa_cache {
+public:
+  static constexpr char const *suffix = ".gsidx";
+  static constexpr char const *tmp_infix = ".tmp.";
+  static constexpr std::chrono::hours stale_tmp_age{24};
+
+  sa_cache(std::string directory, uint64_t const max_bytes)
+      : directory_(std::move(directory)), max_bytes_(max_bytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+  }
+
+  template<typename index_type, typename value_type>
+  mapped_index<index_type, value_type>
+  get_or_build(value_type const *const text, size_t const n,
+               index_file_options const &options = {}) {
+    uint64_t const text_hash = fingerprint_parallel(
+        text, n * sizeof(value_type), options.threads);
+    std::string const path = entry_path<index_type, value_type>(text_hash, n);
+
+    mapped_index<index_type, value_type> result(path.c_str());
+    if (result && result.header().text_hash == text_hash &&
+        result.size() == n && has_sections(result.header(), options)) {
+      ++hits_;
+      touch(path);
+      return result;
+    }
+
+    ++misses_;
+    // build under a name unique to this call (the cache may be shared by
+    // threads and processes) and publish atomically
+    std::string const tmp_path = path + tmp_infix + std::to_string(getpid()) +
+                                 "." + std::to_string(next_tmp_id());
+    if (!build_index_file<index_type>(tmp_path.c_str(), text, n, text_hash,
+                                      options) ||
+        std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+      return {};
+    }
+    evict(path);
+    return mapped_index<index_type, value_type>(path.c_str());
+  }
+
+  uint64_t hits() const {
+    return hits_;
+  }
+
+  uint64_t misses() const {
+    return misses_;
+  }
+
+  // total size of all cache entries and temporary files in bytes
+  uint64_t size() const {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (auto const &entry :
+        std::filesystem::directory_iterator(directory_, ec)) {
+      if (is_entry(entry) || is_tmp(entry)) total += entry.file_size(ec);
+    }
+    return total;
+  }
+
+private:
+  template<typename index_type, typename value_type>
+  std::string entry_path(uint64_t const text_hash, size_t const n) const {
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%llu-%zu-%zu",
+             (unsigned long long) text_hash, (unsigned long long) n,
+             sizeof(index_type), sizeof(value_type));
+    return directory_ + "/" + name + suffix;
+  }
+
+  static bool has_sections(index_file_header const &header,
+                           index_file_options const &options) {
+    return (!options.isa || header.has(section_isa)) &&
+           (!options.lcp || header.has(section_lcp)) &&
+           (!options.bwt || header.has(section_bwt));
+  }
+
+  static bool is_entry(std::filesystem::directory_entry const &entry) {
+    return entry.is_regular_file() && entry.path().extension() == suffix;
+  }
+
+  static bool is_tmp(std::filesystem::directory_entry const &entry) {
+    return entry.is_regular_file() &&
+           entry.path().filename().string().find(
+               std::string(suffix) + tmp_infix) != std::string::npos;
+  }
+
+  // the writer of a temporary file has exited, or it has been idle too long
+  static bool is_stale_tmp(std::filesystem::directory_entry const &entry) {
+    std::error_code ec;
+    auto const last_write = entry.last_write_time(ec);
+    if (!ec && last_write + stale_tmp_age <
+               std::filesystem::file_time_type::clock::now()) {
+      return true;
+    }
+    std::string const name = entry.path().filename().string();
+    size_t const pid_start = name.rfind(tmp_infix) + strlen(tmp_infix);
+    long const pid = strtol(name.c_str() + pid_start, nullptr, 10);
+    return pid > 0 && kill((pid_t) pid, 0) != 0 && errno == ESRCH;
+  }
+
+  static uint64_t next_tmp_id() {
+    static std::atomic<uint64_t> id{0};
+    return id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void touch(std::string const &path) {
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  }
+
+  void evict(std::string const &keep) const {
+    struct cache_entry {
+      std::filesystem::path path;
+      std::filesystem::file_time_type last_use;
+      uint64_t bytes;
+    };
+    std::vector<cache_entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (auto const &entry :
+        std::filesystem::directory_iterator(directory_, ec)) {
+      if (is_tmp(entry)) {
+        // builds in progress count against the limit but are not evicted
+        uint64_t const bytes = entry.file_size(ec);
+        bool const removed = is_stale_tmp(entry) &&
+                             std::filesystem::remove(entry.path(), ec);
+        if (!removed) total += bytes;
+        continue;
+      }
+      if (!is_entry(entry)) continue;
+      entries.push_back(cache_entry{entry.path(), entry.last_write_time(ec),
+                                    entry.file_size(ec)});
+      total += entries.back().bytes;
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](cache_entry const &a, cache_entry const &b) {
+                  return a.last_use < b.last_use;
+              });
+    for (auto const &entry : entries) {
+      if (total <= max_bytes_) break;
+      if (entry.path == keep) continue;
+      if (std::filesystem::remove(entry.path, ec)) total -= entry.bytes;
+    }
+  }
+
+  std::string directory_;
+  uint64_t max_bytes_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}
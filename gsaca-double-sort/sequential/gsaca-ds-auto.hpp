@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../auto_profile.hpp"
+#include "gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+namespace auto_internal {
+
+template<typename p1_sorter, typename p2_sorter, typename buffer_type,
+    typename index_type, typename value_type, typename observer_type>
+static void run_flags(value_type const *const text, index_type *const sa,
+                      size_t const n, gsaca_config const &config,
+                      observer_type observer) {
+  if (config.use_flags)
+    gsaca_ds<p1_sorter, p2_sorter, buffer_type, true>(
+        text, sa, n, config.prefix, observer);
+  else
+    gsaca_ds<p1_sorter, p2_sorter, buffer_type, false>(
+        text, sa, n, config.prefix, observer);
+}
+
+template<typename p1_sorter, typename p2_sorter,
+    typename index_type, typename value_type, typename observer_type>
+static void run_buffer(value_type const *const text, index_type *const sa,
+                       size_t const n, gsaca_config const &config,
+                       observer_type observer) {
+  // the auto buffer type is the index type for up to five bytes
+  if constexpr (sizeof(index_type) > 5) {
+    if (config.wide_buffer) {
+      run_flags<p1_sorter, p2_sorter, index_type>(text, sa, n, config,
+                                                  observer);
+      return;
+    }
+  }
+  run_flags<p1_sorter, p2_sorter, auto_buffer_type>(text, sa, n, config,
+                                                    observer);
+}
+
+template<typename p1_sorter,
+    typename index_type, typename value_type, typename observer_type>
+static void run_p2(value_type const *const text, index_type *const sa,
+                   size_t const n, gsaca_config const &config,
+                   observer_type observer) {
+  switch (config.p2_sorter) {
+    case sorter_id_lsd:
+      run_buffer<p1_sorter, LSD>(text, sa, n, config, observer);
+      break;
+    case sorter_id_ips4o:
+      run_buffer<p1_sorter, IPS4O>(text, sa, n, config, observer);
+      break;
+    default:
+      run_buffer<p1_sorter, MSD>(text, sa, n, config, observer);
+  }
+}
+
+// upper bound on the number of distinct symbols: exact for byte alphabets,
+// the largest symbol plus one otherwise
+template<typename value_type>
+static size_t alphabet_size(value_type const *const text, size_t const n) {
+  if constexpr (sizeof(value_type) == 1) {
+    bool occurs[256] = {};
+    for (size_t i = 0; i < n; ++i) occurs[text[i]] = true;
+    size_t sigma = 0;
+    for (size_t c = 0; c < 256; ++c) sigma += occurs[c];
+    return sigma;
+  } else {
+    value_type max_symbol = 0;
+    for (size_t i = 0; i < n; ++i) max_symbol = std::max(max_symbol, text[i]);
+    return (size_t) max_symbol + 1;
+  }
+}
+
+}
+
+template<typename value_type>
+static gsaca_config select_config(value_type const *const text,
+                                  size_t const n) {
+  size_t const sigma = auto_internal::alphabet_size(text, n);
+  for (auto const &entry : auto_profile::entries) {
+    if (n <= entry.max_n && sigma <= entry.max_sigma) return entry.config;
+  }
+  return gsaca_config{sorter_id_msd, sorter_id_msd, true, false, 1};
+}
+
+// gsaca_ds with the template parameters given at runtime
+template<typename index_type, typename value_type,
+    typename observer_type = no_observer>
+static void gsaca_ds_configured(value_type const *const text,
+                                index_type *const sa, size_t const n,
+                                gsaca_config const &config,
+                                observer_type observer = observer_type()) {
+  switch (config.p1_sorter) {
+    case sorter_id_lsd:
+      auto_internal::run_p2<LSD>(text, sa, n, config, observer);
+      break;
+    case sorter_id_ips4o:
+      auto_internal::run_p2<IPS4O>(text, sa, n, config, observer);
+      break;
+    default:
+      auto_internal::run_p2<MSD>(text, sa, n, config, observer);
+  }
+}
+
+// gsaca_ds with the configuration from auto_profile.hpp, which is generated
+// by benchmark/autotune --emit-profile
+template<typename index_type, typename value_type,
+    typename observer_type = no_observer>
+static void gsaca_ds_auto(value_type const *const text, index_type *const sa,
+                          size_t const n,
+                          observer_type observer = observer_type()) {
+  gsaca_ds_configured(text, sa, n, select_config(text, n), observer);
+}
+
+}
@@ -17,7 +17,7 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
   static_assert(std::is_unsigned<index_type>::value);
   static_assert(std::is_unsigned<used_buffer_type>::value);
   static_assert(check_buffer_type<buffer_type, index_type, used_buffer_type>);
-  //static_assert(sizeof(value_type) == 1);
+  static_assert(sizeof(value_type) <= 2);
   static_assert(sizeof(used_buffer_type) >= 4);
 
   using count_type = get_count_type<used_buffer_type, index_type>;
@@ -26,7 +26,9 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
   using p1_stack_type = phase_1_stack_type<used_buffer_type>;
   using F = flag_type<use_flags>;
 
-  constexpr count_type MAX_HASHING = 8;
+  // nano texts pack up to 8 bytes or 4 16-bit symbols into 64 bits
+  constexpr count_type SYMBOL_BITS = sizeof(value_type) * 8;
+  constexpr count_type MAX_HASHING = 64 / SYMBOL_BITS;
 
   auto lce = [&](count_type const i, count_type const j) {
       count_type lce = 0;
@@ -83,7 +85,8 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
     used_buffer_type first;
 
     gsaca_always_inline count_type lyndon() const {
-      return 8 - (__builtin_ctzl(text) >> 3);
+      return 64 / (sizeof(value_type) * 8) -
+             __builtin_ctzl(text) / (sizeof(value_type) * 8);
     }
   } __attribute((packed));
 
@@ -94,7 +97,8 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
     uint8_t dummy[std::max((int64_t) 1, pad)] = {};
 
     gsaca_always_inline count_type lyndon() const {
-      return 8 - (__builtin_ctzl(text) >> 3);
+      return 64 / (sizeof(value_type) * 8) -
+             __builtin_ctzl(text) / (sizeof(value_type) * 8);
     }
   } __attribute((packed));
 
@@ -110,6 +114,7 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
       nano_text{0, (used_buffer_type) n - 1}); // group of n - 1
   to_sort_nano.emplace_back(nano_text{0x100, 0}); // group of 0
   {
+    // single symbols, and pairs of bytes (larger than any single byte)
     std::vector<used_buffer_type> first_occ_lookup16(std::pow(2, 16));
     unordered_map64 first_occ_lookup64;
 
@@ -122,11 +127,12 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
           used_buffer_type &first = first_occ_lookup16[text[i]];
           if (gsaca_unlikely(first == 0)) {
             first = i;
-            to_sort_nano.emplace_back(nano_text{((uint64_t) text[i]) << 56, i});
+            to_sort_nano.emplace_back(
+                nano_text{((uint64_t) text[i]) << (64 - SYMBOL_BITS), i});
           } else {
             nano_id_of[i] = first;
           }
-        } else if (lyndon_i == 2) {
+        } else if (SYMBOL_BITS == 8 && lyndon_i == 2) {
           uint64_t const nano = ((uint64_t) text[i]) << 8 | text[i + 1];
           used_buffer_type &first = first_occ_lookup16[nano];
           if (gsaca_unlikely(first == 0)) {
@@ -140,13 +146,14 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
           auto const lyn = std::min(lyndon_i, MAX_HASHING);
           uint64_t nano = text[i];
           for (count_type j = 1; j < lyn; ++j) {
-            nano <<= 8;
+            nano <<= SYMBOL_BITS;
             nano |= text[i + j];
           }
           used_buffer_type &first = first_occ_lookup64[nano];
           if (gsaca_unlikely(first == 0)) {
             first = i;
-            to_sort_nano.emplace_back(nano_text{nano << ((8 - lyn) << 3), i});
+            to_sort_nano.emplace_back(
+                nano_text{nano << ((MAX_HASHING - lyn) * SYMBOL_BITS), i});
           } else {
             nano_id_of[i] = first;
             if (lyn < MAX_HASHING) {
@@ -160,7 +167,7 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
       } else {
         uint64_t nano = text[i];
         for (count_type j = 1; j < MAX_HASHING; ++j) {
-          nano <<= 8;
+          nano <<= SYMBOL_BITS;
           nano |= text[i + j];
         }
         used_buffer_type &first = first_occ_lookup64[nano];
@@ -181,11 +188,11 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
             if (gsaca_unlikely(first == 0)) {
               first = i;
               to_sort_nano.emplace_back(
-                  nano_text{((uint64_t) text[i]) << 56, i});
+                  nano_text{((uint64_t) text[i]) << (64 - SYMBOL_BITS), i});
             } else {
               nano_id_of[i] = first;
             }
-          } else if (lyn == 2) {
+          } else if (SYMBOL_BITS == 8 && lyn == 2) {
             uint64_t const nano = ((uint64_t) text[i]) << 8 | text[i + 1];
             used_buffer_type &first = first_occ_lookup16[nano];
             if (gsaca_unlikely(first == 0)) {
@@ -198,13 +205,14 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
           } else {
             uint64_t nano = text[i];
             for (count_type j = 1; j < lyn; ++j) {
-              nano <<= 8;
+              nano <<= SYMBOL_BITS;
               nano |= text[i + j];
             }
             used_buffer_type &first = first_occ_lookup64[nano];
             if (gsaca_unlikely(first == 0)) {
               first = i;
-              to_sort_nano.emplace_back(nano_text{nano << ((8 - lyn) << 3), i});
+              to_sort_nano.emplace_back(
+                nano_text{nano << ((MAX_HASHING - lyn) * SYMBOL_BITS), i});
             } else {
               nano_id_of[i] = first;
               for (count_type j = 1; j < lyn; ++j) {
@@ -215,9 +223,11 @@ static void gsaca_hash_ds(value_type const *const text, index_type *const sa,
           }
         }
 
-        // now we have i = original i + period
+        // now we have i >= original i + period (a lyndon word may end
+        // behind the first period)
+        count_type const copy_end = stop + (repetitions - 2) * period;
         count_type const last_copy =
-            i + (repetitions - 2) * period - MAX_HASHING;
+            (copy_end > MAX_HASHING) ? (copy_end - MAX_HASHING) : 0;
 
         for (; i < last_copy; ++i) {
           nano_id_of[i] = i - period;
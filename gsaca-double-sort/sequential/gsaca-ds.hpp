@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../extract.hpp"
+#include "../periodic.hpp"
 #include "phase_1.hpp"
 #include "phase_2.hpp"
 
@@ -17,59 +18,112 @@ auto sort_by_prefix(value_type const *const text, index_type *const sa,
   using p1_stack_type = phase_1_stack_type<buffer_type>;
   using p1_group_type = typename p1_stack_type::value_type;
 
+  // bytes and 16-bit symbols are sorted by counting (one bucket per symbol)
+  constexpr bool small_alphabet = sizeof(value_type) <= 2;
+  constexpr count_type symbols =
+      1ULL << (small_alphabet ? (sizeof(value_type) * 8) : 8);
+
   p1_stack_type result;
-  if (sizeof(value_type) == 1) {
-      if (prefix == 1) {
-        count_type histogram[256] = {};
-        for (count_type i = 0; i < n; ++i) {
-          ++histogram[text[i]];
-        }
-        count_type *const borders = histogram;
-        count_type left_border = 2;
-        for (count_type b = 1; b < 256; ++b) {
-          count_type gsize = histogram[b];
-          borders[b] = left_border;
-          if (gsize > 0) {
-            result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
-          }
-          left_border += gsize;
-        }
-        borders[0] = 0;
-        for (count_type i = 0; i < n; ++i) {
-          sa[borders[text[i]]++] = i;
+  if (small_alphabet && prefix == 1) {
+      std::vector<count_type> histogram(symbols);
+      for (count_type i = 0; i < n; ++i) {
+        ++histogram[text[i]];
+      }
+      count_type *const borders = histogram.data();
+      count_type left_border = 2;
+      for (count_type b = 1; b < symbols; ++b) {
+        count_type gsize = histogram[b];
+        borders[b] = left_border;
+        if (gsize > 0) {
+          result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
         }
-      } else {
-        count_type const buckets = 1ULL << (prefix << 3);
-        std::vector<count_type> histogram(buckets);
-        count_type const stop = n - prefix - 1;
+        left_border += gsize;
+      }
+      borders[0] = 0;
+      for (count_type i = 0; i < n; ++i) {
+        sa[borders[text[i]]++] = i;
+      }
+  } else if (sizeof(value_type) == 1) {
+      count_type const buckets = 1ULL << (prefix << 3);
+      std::vector<count_type> histogram(buckets);
+      count_type const stop = n - prefix - 1;
 
-        for (count_type i = 1; i < stop; ++i) {
-          ++histogram[extract(text, i, prefix)];
-        }
-        for (count_type i = stop; i < n - 1; ++i) {
-          ++histogram[safe_extract(text, i, prefix)];
-        }
+      for (count_type i = 1; i < stop; ++i) {
+        ++histogram[extract(text, i, prefix)];
+      }
+      for (count_type i = stop; i < n - 1; ++i) {
+        ++histogram[safe_extract(text, i, prefix)];
+      }
 
-        count_type *const borders = histogram.data();
-        count_type left_border = 2;
-        for (count_type b = buckets >> 8; b < buckets; ++b) {
-          count_type gsize = histogram[b];
-          borders[b] = left_border;
-          if (gsize > 0) {
-            result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
-          }
-          left_border += gsize;
+      count_type *const borders = histogram.data();
+      count_type left_border = 2;
+      for (count_type b = buckets >> 8; b < buckets; ++b) {
+        count_type gsize = histogram[b];
+        borders[b] = left_border;
+        if (gsize > 0) {
+          result.emplace_back(p1_group_type{left_border, gsize, 1, true, false});
         }
+        left_border += gsize;
+      }
 
     	for (count_type i = 1; i < stop; ++i) {
       	    sa[borders[extract(text, i, prefix)]++] = F::conditional_add_flag(
-          	text[i - 1] < text[i], i);
+        	text[i - 1] < text[i], i);
     	}
     	for (count_type i = stop; i < n - 1; ++i) {
-            sa[borders[safe_extract(text, i, prefix)]++] = F::conditional_add_flag(
-          	text[i - 1] < text[i], i);
+          sa[borders[safe_extract(text, i, prefix)]++] = F::conditional_add_flag(
+        	text[i - 1] < text[i], i);
     	}
+  } else if (small_alphabet && prefix == 2) {
+      // 16-bit symbols: stable counting sort by the second symbol, then by
+      // the first symbol (a table of all pairs would be too large)
+      std::vector<count_type> histogram(symbols);
+      index_type *const by_second =
+          (index_type *) malloc((n - 2) * sizeof(index_type));
+      for (count_type i = 2; i < n; ++i) {
+        ++histogram[text[i]];
+      }
+      count_type border = 0;
+      for (count_type b = 0; b < symbols; ++b) {
+        count_type const gsize = histogram[b];
+        histogram[b] = border;
+        border += gsize;
+      }
+      for (count_type i = 1; i < n - 1; ++i) {
+        by_second[histogram[text[i + 1]]++] = i;
+      }
+
+      std::fill(histogram.begin(), histogram.end(), 0);
+      for (count_type i = 1; i < n - 1; ++i) {
+        ++histogram[text[i]];
       }
+      border = 2;
+      for (count_type b = 1; b < symbols; ++b) {
+        count_type const gsize = histogram[b];
+        histogram[b] = border;
+        border += gsize;
+      }
+      for (count_type j = 0; j < n - 2; ++j) {
+        count_type const i = by_second[j];
+        sa[histogram[text[i]]++] = F::conditional_add_flag(
+            text[i - 1] < text[i], i);
+      }
+      free(by_second);
+
+      // groups of equal pairs
+      count_type left_border = 2;
+      auto previous = extract(text, F::remove_flag(sa[2]), 2);
+      for (count_type j = 3; j < n; ++j) {
+        auto const current = extract(text, F::remove_flag(sa[j]), 2);
+        if (current != previous) {
+          result.emplace_back(p1_group_type{left_border, j - left_border, 1,
+                                            true, false});
+          left_border = j;
+          previous = current;
+        }
+      }
+      result.emplace_back(p1_group_type{left_border, n - left_border, 1,
+                                        true, false});
   }
   else {
       // fill sa with values
@@ -105,6 +159,33 @@ auto sort_by_prefix(value_type const *const text, index_type *const sa,
   return result;
 }
 
+template<typename p1_sorter, typename p2_sorter, typename buffer_type,
+    typename F, typename index_type, typename value_type,
+    typename observer_type>
+static void gsaca_ds_phases(value_type const *const text, index_type *const sa,
+                            size_t const n, size_t const prefix,
+                            observer_type observer, F const flags) {
+  observer.phase_begin(gsaca_phase::sort_by_prefix);
+  auto p1_input_groups = sort_by_prefix<buffer_type, F>(text, sa, n, prefix);
+  observer.phase_end(gsaca_phase::sort_by_prefix);
+
+  buffer_type *const isa = (buffer_type *) malloc(n * sizeof(buffer_type));
+
+  observer.phase_begin(gsaca_phase::phase_1);
+  auto p2_input_groups = phase_1_by_sorting<p1_sorter, F>(sa, isa,
+                                                          p1_input_groups,
+                                                          observer);
+  observer.phase_end(gsaca_phase::phase_1);
+
+  if (!observer.stop_requested()) {
+    observer.phase_begin(gsaca_phase::phase_2);
+    phase_2_by_sorting<p2_sorter, F>(sa, isa, n, p2_input_groups.data(),
+                                     p2_input_groups.size(), observer, flags);
+    observer.phase_end(gsaca_phase::phase_2);
+  }
+  free(isa);
+}
+
 }
 
 template<typename p1_sorter = MSD, typename p2_sorter = MSD,
@@ -112,9 +193,11 @@ template<typename p1_sorter = MSD, typename p2_sorter = MSD,
     bool use_flags = true,
     typename index_type, // auto deduce
     typename value_type, // auto deduce
-    typename used_buffer_type = get_buffer_type <buffer_type, index_type>>
+    typename used_buffer_type = get_buffer_type <buffer_type, index_type>,
+    typename observer_type = no_observer>
 static void gsaca_ds(value_type const *const text, index_type *const sa,
-                     size_t const n, size_t const initial_sort_prefix_len = 1) {
+                     size_t const n, size_t const initial_sort_prefix_len = 1,
+                     observer_type observer = observer_type()) {
   static_assert(std::is_unsigned<value_type>::value);
   static_assert(std::is_unsigned<index_type>::value);
   static_assert(std::is_unsigned<used_buffer_type>::value);
@@ -122,21 +205,32 @@ static void gsaca_ds(value_type const *const text, index_type *const sa,
 
   using F = flag_type<use_flags>;
 
-  auto p1_input_groups =
-      double_sort_internal::sort_by_prefix<used_buffer_type, F>(
-          text, sa, n, initial_sort_prefix_len);
-
-  used_buffer_type *const isa =
-      (used_buffer_type *) malloc(n * sizeof(used_buffer_type));
-
-
-  auto p2_input_groups = phase_1_by_sorting<p1_sorter, F>(sa, isa,
-                                                          p1_input_groups);
+  // periodic texts are sorted arithmetically (see periodic.hpp)
+  if (size_t const period = detect_period(text, n); period > 0) {
+    periodic_sa(text, sa, n, period, 1, observer,
+                [&](value_type const *const y, index_type *const y_sa,
+                    size_t const y_n) {
+                    gsaca_ds<p1_sorter, p2_sorter, buffer_type, use_flags>(
+                        y, y_sa, y_n, initial_sort_prefix_len,
+                        periodic_internal::stop_observer::of(observer));
+                });
+    return;
+  }
 
-  phase_2_by_sorting<p2_sorter, F>(sa, isa, n, p2_input_groups.data(),
-                                   p2_input_groups.size());
-                                   
-  free(isa);
+  if constexpr (use_flags) {
+    // flags do not fit into the entries, keep them in a side bitvector
+    using count_type = get_count_type<index_type, used_buffer_type>;
+    if (!flag_bits_fit<index_type, used_buffer_type, count_type>(n)) {
+      flag_type_side const flags{flag_type_side::build(text, n)};
+      double_sort_internal::gsaca_ds_phases<p1_sorter, p2_sorter,
+          used_buffer_type>(text, sa, n, initial_sort_prefix_len, observer,
+                            flags);
+      free((void *) flags.bits);
+      return;
+    }
+  }
+  double_sort_internal::gsaca_ds_phases<p1_sorter, p2_sorter,
+      used_buffer_type>(text, sa, n, initial_sort_prefix_len, observer, F());
 }
 
 template<typename p1_sorter = MSD, typename p2_sorter = MSD,
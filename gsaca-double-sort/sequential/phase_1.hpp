@@ -9,9 +9,11 @@
 namespace gsaca_lyndon {
 
 template<typename sorter, typename F = flag_type<false>,
-    typename index_type, typename buffer_type>
+    typename index_type, typename buffer_type,
+    typename observer_type = no_observer>
 inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
-                               phase_1_stack_type<buffer_type> &input_groups) {
+                               phase_1_stack_type<buffer_type> &input_groups,
+                               observer_type observer = observer_type()) {
   using count_type = get_count_type<index_type, buffer_type>;
   using output_type = phase_2_group_type<buffer_type>;
   using input_type = phase_1_group_type<buffer_type>;
@@ -29,14 +31,19 @@ inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
   memset(rank, 0, n * sizeof(buffer_type));
 
   std::vector<output_type> result_groups(1);
+  count_type assigned = 2; // the sentinels
 
-  // twice the size for out-of-place radix sort
-  sorting_type *to_sort = (sorting_type *) malloc(
-      (max_group_size) * sizeof(sorting_type) * 2);
+  // twice the size for out-of-place radix sort, plus one element in front
+  // (insertion sort uses to_sort[-1] as a sentinel)
+  sorting_type *const to_sort_memory = (sorting_type *) malloc(
+      (2 * max_group_size + 1) * sizeof(sorting_type));
+  sorting_type *const to_sort = to_sort_memory + 1;
 
   buffer_type *const subgroup_id = (buffer_type *) to_sort;
 
   while (!input_groups.empty()) {
+    observer.phase_1_progress(assigned, n);
+    if (gsaca_unlikely(observer.stop_requested())) break;
     auto const group = input_groups.back();
     input_groups.pop_back();
 
@@ -53,6 +60,7 @@ inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
         context += result_groups[rank[idx + context]].lyndon;
       }
       result_groups.emplace_back(output_type{context, 1});
+      ++assigned;
     } else if (!group.check_for_runs) {
       // this group can directly be processed
       if (group.is_final) {
@@ -62,6 +70,7 @@ inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
           rank[F::remove_flag(sa_interval[i])] = assign_rank;
         }
         result_groups.emplace_back(output_type{gcontext, gsize});
+        assigned += gsize;
       } else {
         // let's sort the group by the rank behind the context
         for (count_type i = 0; i < gsize; ++i) {
@@ -73,7 +82,7 @@ inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
 
         size_t max_rank = result_groups.size() - 1;
         // decreasing sort, stable sort
-        sorter::template sort<false, true>(to_sort, to_sort + gsize, gsize,
+        sorter::template sort<false, true, F>(to_sort, to_sort + gsize, gsize,
                                            max_rank);
 
         for (count_type i = 0; i < gsize; ++i) {
@@ -159,7 +168,7 @@ inline auto phase_1_by_sorting(index_type *const sa, buffer_type *const isa,
   sa[1] = 0;
   std::reverse(result_groups.begin(), result_groups.end());
   result_groups.resize(result_groups.size() - 1);
-  free(to_sort);
+  free(to_sort_memory);
   return result_groups;
 }
 
@@ -6,11 +6,14 @@
 namespace gsaca_lyndon {
 
 template<typename sorter, typename F = flag_type<false>,
-    typename index_type, typename buffer_type>
+    typename index_type, typename buffer_type,
+    typename observer_type = no_observer>
 inline void
 phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
                    phase_2_group_type<buffer_type> const *const groups,
-                   size_t const number_of_groups) {
+                   size_t const number_of_groups,
+                   observer_type observer = observer_type(),
+                   F const flags = F()) {
 
   using count_type = get_count_type<index_type, buffer_type>;
   using key_value_pair = radix_key_val_pair<buffer_type>;
@@ -23,7 +26,7 @@ phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
   constexpr count_type sg_count_threshold = 256ULL * 1024; // 1MiB buffer
   void *memory = malloc(
       sg_count_threshold * sizeof(count_type) +
-      ((max_group_size + 1) << 1) * sizeof(key_value_pair));
+      (((size_t) max_group_size + 1) << 1) * sizeof(key_value_pair));
 
   count_type *const subgroup_border_buffer = (count_type *) memory;
   key_value_pair *grouped_indices = (key_value_pair *) (subgroup_border_buffer +
@@ -37,6 +40,7 @@ phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
 
   count_type left_border = 2;
   for (count_type g = 2; g < number_of_groups; ++g) {
+    if (gsaca_unlikely(observer.stop_requested())) break;
     count_type const gsize = groups[g].size;
     if (gsize == 1) {
       sa[left_border] = F::remove_flag(sa[left_border]);
@@ -92,7 +96,8 @@ phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
               F::remove_flag(grouped_indices[i].value) + lyn];
         }
 
-        if (gsaca_likely(stop - previous_border < 33)) {
+        if (gsaca_likely(stop - previous_border <=
+                         radix_internal::insertion_threshold)) {
           radix_internal::insertion<true>(
               &(grouped_indices[previous_border]), stop - previous_border);
         } else {
@@ -108,7 +113,7 @@ phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
           sa_interval[i] = grouped_indices[i].value;
         }
         for (count_type i = previous_border; i < stop; ++i) {
-          if (!F::is_flagged(sa_interval[i])) {
+          if (!flags.is_flagged(sa_interval[i])) {
             isa[sa_interval[i]] = left_border + i;
           } else {
             sa_interval[i] = F::remove_flag(sa_interval[i]);
@@ -123,6 +128,7 @@ phase_2_by_sorting(index_type *const sa, buffer_type *const isa, size_t const n,
 
       left_border += gsize;
     }
+    observer.phase_2_progress(sa, left_border);
   }
 
   free(memory);
@@ -0,0 +1,402 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "sequential/gsaca-ds.hpp"
+
+namespace gsaca_lyndon {
+
+// Suffix array and inverse suffix array of a sliding window over a stream of
+// non-zero symbols. The window holds the last (at most) window symbols; it is
+// stored with the usual sentinels, i.e. text()[0] and text()[size() - 1] are
+// zero, and suffix(i) and rank(i) are sa[i] and isa[i] with the conventions
+// of gsaca_ds (copy_sa and copy_isa write the whole arrays).
+//
+// Advancing by a block keeps the order of most suffixes: dropping symbols at
+// the front does not change the remaining suffixes, and appending symbols
+// only changes the order of suffixes that are a prefix of another suffix.
+// These are dirty, and they form a tail of the old window: if the suffix at
+// j is a prefix of the one at i, then the suffix at j + 1 is a prefix of the
+// one at i + 1. A suffix is a prefix of another one iff it is a prefix of
+// its successor in the suffix array, thus the tail is found by galloping.
+// The dirty tail and the new block are sorted by gsaca_ds and inserted into
+// the order of the clean suffixes.
+//
+// The order is kept in a treap whose nodes are the stream positions modulo
+// window (priorities are hashes of the positions), i.e. a suffix entering
+// the window reuses the node of the one that left it, and no position or
+// rank is ever rewritten. The text is kept in a buffer of twice the window
+// and moved to its front once the window reaches the end of the buffer.
+// Thus, an advance costs O(log window) expected time per removed, dirty and
+// inserted suffix, plus the suffix comparisons of the insertions; they start
+// at the previously inserted suffix (finger search). If the tail is long,
+// the window is sorted from scratch instead.
+namespace sliding_internal {
+
+// treap priority of a stream position (finalizer of splitmix64)
+inline uint64_t priority(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}
+
+template<typename index_type, typename value_type>
+class sliding_window_sa {
+  static_assert(std::is_unsigned<value_type>::value);
+  static_assert(std::is_unsigned<index_type>::value);
+
+public:
+  // at most one in this many suffixes re-sorted, otherwise gsaca_ds is used
+  // for the whole window (on 2^22 random symbols, inserting 2^19 suffixes
+  // takes as long as sorting from scratch)
+  static constexpr size_t max_tail_divisor = 16;
+
+  // window must be positive
+  explicit sliding_window_sa(size_t const window)
+      : window_(window), text_(2 * window + 2, 0), left_(window),
+        right_(window), parent_(window), count_(window), root_(window) {}
+
+  // Appends the symbols and drops the oldest ones beyond the window.
+  void advance(value_type const *block, size_t length) {
+    if (length == 0) return;
+    if (length > window_) {
+      // the front of the block leaves the window right away, and with it
+      // all current suffixes
+      start_ += m_ + (length - window_);
+      m_ = 0;
+      base_ = start_;
+      root_ = nil();
+      block += length - window_;
+      length = window_;
+    }
+    uint64_t const end = start_ + m_;
+    size_t const new_m = std::min(window_, m_ + length);
+    size_t const removed = m_ + length - new_m;
+
+    uint64_t const tail_begin = std::max(end - dirty_tail(),
+                                         start_ + removed);
+    size_t const tail = end + length - tail_begin;
+    bool const rebuild = tail * max_tail_divisor > new_m;
+    if (!rebuild) {
+      for (uint64_t j = start_; j < start_ + removed; ++j) erase(slot(j));
+      for (uint64_t j = tail_begin; j < end; ++j) erase(slot(j));
+    }
+
+    start_ += removed;
+    m_ = new_m;
+    if (index(end + length) >= text_.size()) {
+      // happens at most once per window symbols appended
+      memmove(&text_[1], &text_[index(start_)],
+              (end - start_) * sizeof(value_type));
+      base_ = start_;
+    }
+    value_type *const append = &text_[index(end)];
+    for (size_t i = 0; i < length; ++i) append[i] = block[i];
+    text_[index(end + length)] = 0;
+    text_[index(start_) - 1] = 0;
+
+    if (rebuild) sort_window();
+    else insert_tail(tail_begin, tail);
+  }
+
+  value_type const *text() const {
+    return &text_[index(start_) - 1];
+  }
+
+  // window length plus the two sentinels
+  size_t size() const {
+    return m_ + 2;
+  }
+
+  // sa[i], in O(log window) expected time
+  uint64_t suffix(size_t i) const {
+    if (i < 2) return (i == 0) ? m_ + 1 : 0;
+    i -= 2;
+    size_t node = root_;
+    while (true) {
+      size_t const smaller = count(left_[node]);
+      if (i == smaller) return position(node) - start_ + 1;
+      if (i < smaller) {
+        node = left_[node];
+      } else {
+        i -= smaller + 1;
+        node = right_[node];
+      }
+    }
+  }
+
+  // isa[i], in O(log window) expected time
+  size_t rank(uint64_t const i) const {
+    if (i == 0 || i == m_ + 1) return (i == 0) ? 1 : 0;
+    size_t node = slot(start_ + i - 1);
+    size_t result = 2 + count(left_[node]);
+    for (size_t up = parent_[node]; up != nil(); up = parent_[up]) {
+      if ((uint64_t) right_[up] == node) result += count(left_[up]) + 1;
+      node = up;
+    }
+    return result;
+  }
+
+  // writes the size() entries of sa, in O(window) time
+  void copy_sa(index_type *const sa) const {
+    sa[0] = m_ + 1;
+    sa[1] = 0;
+    size_t i = 2;
+    for (size_t node = first(); node != nil(); node = successor(node)) {
+      sa[i++] = position(node) - start_ + 1;
+    }
+  }
+
+  // writes the size() entries of isa, in O(window) time
+  void copy_isa(index_type *const isa) const {
+    isa[0] = 1;
+    isa[m_ + 1] = 0;
+    size_t i = 2;
+    for (size_t node = first(); node != nil(); node = successor(node)) {
+      isa[position(node) - start_ + 1] = i++;
+    }
+  }
+
+  // stream position of text()[1] (number of dropped symbols)
+  uint64_t offset() const {
+    return start_;
+  }
+
+private:
+  size_t nil() const {
+    return window_;
+  }
+
+  // position of a stream position in text_
+  size_t index(uint64_t const j) const {
+    return 1 + j - base_;
+  }
+
+  size_t slot(uint64_t const j) const {
+    return j % window_;
+  }
+
+  // stream position of the suffix at a node
+  uint64_t position(size_t const node) const {
+    return start_ + (node + window_ - start_ % window_) % window_;
+  }
+
+  uint64_t priority(size_t const node) const {
+    return sliding_internal::priority(position(node));
+  }
+
+  size_t count(size_t const node) const {
+    return (node == nil()) ? 0 : (uint64_t) count_[node];
+  }
+
+  // the text ends with a unique sentinel, thus a mismatch is found
+  bool less(uint64_t const a, uint64_t const b) const {
+    size_t i = index(a), j = index(b);
+    while (text_[i] == text_[j]) {
+      ++i;
+      ++j;
+    }
+    return text_[i] < text_[j];
+  }
+
+  size_t first() const {
+    size_t node = root_;
+    if (node == nil()) return nil();
+    while ((uint64_t) left_[node] != nil()) node = left_[node];
+    return node;
+  }
+
+  size_t successor(size_t node) const {
+    if ((uint64_t) right_[node] != nil()) {
+      node = right_[node];
+      while ((uint64_t) left_[node] != nil()) node = left_[node];
+      return node;
+    }
+    size_t up = parent_[node];
+    while (up != nil() && (uint64_t) right_[up] == node) {
+      node = up;
+      up = parent_[up];
+    }
+    return up;
+  }
+
+  void update_count(size_t const node) {
+    count_[node] = 1 + count(left_[node]) + count(right_[node]);
+  }
+
+  // rotates node above its parent
+  void rotate_up(size_t const node) {
+    size_t const up = parent_[node];
+    size_t const grand = parent_[up];
+    if ((uint64_t) left_[up] == node) {
+      size_t const middle = right_[node];
+      left_[up] = middle;
+      if (middle != nil()) parent_[middle] = up;
+      right_[node] = up;
+    } else {
+      size_t const middle = left_[node];
+      right_[up] = middle;
+      if (middle != nil()) parent_[middle] = up;
+      left_[node] = up;
+    }
+    parent_[up] = node;
+    parent_[node] = grand;
+    if (grand == nil()) root_ = node;
+    else if ((uint64_t) left_[grand] == up) left_[grand] = node;
+    else right_[grand] = node;
+    update_count(up);
+    update_count(node);
+  }
+
+  // Inserts the suffix at node, which is larger than the one at finger
+  // (unless finger is nil). The search ascends from finger to the lowest
+  // left child whose parent is larger, from there on all larger suffixes
+  // are in its subtree.
+  void insert(size_t const node, size_t const finger) {
+    left_[node] = right_[node] = nil();
+    count_[node] = 1;
+    if (root_ == nil()) {
+      parent_[node] = nil();
+      root_ = node;
+      return;
+    }
+    uint64_t const p = position(node);
+    size_t at = (finger == nil()) ? root_ : finger;
+    for (size_t up = parent_[at]; up != nil(); up = parent_[up]) {
+      if ((uint64_t) left_[up] == at && less(p, position(up))) break;
+      at = up;
+    }
+    while (true) {
+      bool const smaller = less(p, position(at));
+      size_t const child = smaller ? left_[at] : right_[at];
+      if (child == nil()) {
+        if (smaller) left_[at] = node;
+        else right_[at] = node;
+        break;
+      }
+      at = child;
+    }
+    parent_[node] = at;
+    for (size_t up = at; up != nil(); up = parent_[up]) {
+      count_[up] = (uint64_t) count_[up] + 1;
+    }
+    while ((uint64_t) parent_[node] != nil() &&
+           priority(parent_[node]) < priority(node)) {
+      rotate_up(node);
+    }
+  }
+
+  void erase(size_t const node) {
+    while (true) {
+      size_t const l = left_[node], r = right_[node];
+      if (l == nil() && r == nil()) break;
+      bool const left_up =
+          r == nil() || (l != nil() && priority(l) > priority(r));
+      rotate_up(left_up ? l : r);
+    }
+    size_t const up = parent_[node];
+    if (up == nil()) root_ = nil();
+    else if ((uint64_t) left_[up] == node) left_[up] = nil();
+    else right_[up] = nil();
+    for (size_t a = up; a != nil(); a = parent_[a]) {
+      count_[a] = (uint64_t) count_[a] - 1;
+    }
+  }
+
+  // the suffix at j (a stream position) is a prefix of its successor
+  bool is_dirty(uint64_t const j) const {
+    size_t const next = successor(slot(j));
+    if (next == nil()) return false;
+    size_t const a = index(j), b = index(position(next));
+    // stops at the final sentinel of the successor at the latest
+    for (uint64_t k = 0; j + k < start_ + m_; ++k) {
+      if (text_[a + k] != text_[b + k]) return false;
+    }
+    return true;
+  }
+
+  // number of dirty suffixes, they are the last ones of the window
+  size_t dirty_tail() const {
+    uint64_t const end = start_ + m_;
+    size_t lo = 0, hi = 1;
+    while (hi <= m_ && is_dirty(end - hi)) {
+      lo = hi;
+      hi *= 2;
+    }
+    hi = std::min(hi, m_ + 1);
+    while (hi - lo > 1) {
+      size_t const mid = (lo + hi) / 2;
+      if (is_dirty(end - mid)) lo = mid;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  // Inserts the suffixes at [tail_begin, tail_begin + tail), which end with
+  // the window, in the order computed by gsaca_ds on this part of the text.
+  void insert_tail(uint64_t const tail_begin, size_t const tail) {
+    // the symbol in front of the tail serves as its leading sentinel
+    value_type *const local = &text_[index(tail_begin) - 1];
+    value_type const before = local[0];
+    local[0] = 0;
+    std::vector<index_type> local_sa(tail + 2);
+    gsaca_ds((value_type const *) local, local_sa.data(), tail + 2);
+    local[0] = before;
+
+    size_t finger = nil();
+    for (size_t i = 2; i < tail + 2; ++i) {
+      size_t const node = slot(tail_begin - 1 + (uint64_t) local_sa[i]);
+      insert(node, finger);
+      finger = node;
+    }
+  }
+
+  // Sorts the window with gsaca_ds and builds the treap in linear time: in
+  // suffix order, each node becomes the right child of the last node with a
+  // larger priority, and takes the nodes it pops from the stack as its left
+  // subtree (whose sizes are final at this point).
+  void sort_window() {
+    std::vector<index_type> sa(m_ + 2);
+    gsaca_ds(text(), sa.data(), m_ + 2);
+    std::vector<size_t> stack;
+    for (size_t i = 2; i < m_ + 2; ++i) {
+      size_t const node = slot(start_ - 1 + (uint64_t) sa[i]);
+      uint64_t const p = priority(node);
+      size_t popped = nil();
+      while (!stack.empty() && priority(stack.back()) < p) {
+        popped = stack.back();
+        stack.pop_back();
+        update_count(popped);
+      }
+      left_[node] = popped;
+      right_[node] = nil();
+      if (popped != nil()) parent_[popped] = node;
+      if (stack.empty()) {
+        parent_[node] = nil();
+      } else {
+        right_[stack.back()] = node;
+        parent_[node] = stack.back();
+      }
+      stack.push_back(node);
+    }
+    root_ = stack.empty() ? nil() : stack.front();
+    for (; !stack.empty(); stack.pop_back()) update_count(stack.back());
+  }
+
+  size_t window_;
+  std::vector<value_type> text_; // stream position j at index(j)
+  std::vector<index_type> left_;
+  std::vector<index_type> right_;
+  std::vector<index_type> parent_;
+  std::vector<index_type> count_; // subtree sizes
+  size_t root_;
+  uint64_t start_ = 0; // stream position of the first window symbol
+  uint64_t base_ = 0; // stream position at text_[1]
+  size_t m_ = 0;
+};
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Sorter tuning table, generated by benchmark/sorters --emit-table.
+// The defaults reproduce the original hand-tuned settings (insertion sort
+// below 32 elements, MSD radix sort otherwise, parallel processing of groups
+// with at least 1025 elements). Entries are indexed by the number of key
+// bytes; a size of SIZE_MAX means never.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gsaca_lyndon {
+namespace sorter_tuning {
+
+constexpr char const *machine = "default";
+constexpr size_t insertion_threshold = 32;
+constexpr size_t parallel_threshold = 1025;
+constexpr size_t lsd_min_size[9] = {
+    SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX,
+    SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+constexpr size_t ips4o_min_size[9] = {
+    SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX,
+    SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+
+} // namespace sorter_tuning
+} // namespace gsaca_lyndon
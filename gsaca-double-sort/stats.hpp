@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include "perf_counters.hpp"
+#include "phase_types.hpp"
+
+namespace gsaca_lyndon {
+
+constexpr char const *gsaca_phase_names[gsaca_phase_count] = {
+    "sort_by_prefix", "phase_1", "phase_2"};
+
+struct gsaca_phase_stats {
+  double seconds = 0;
+  perf_counter_values counters;
+};
+
+struct gsaca_stats {
+  gsaca_phase_stats phase[gsaca_phase_count];
+
+  gsaca_phase_stats &operator[](gsaca_phase const p) {
+    return phase[(uint32_t) p];
+  }
+
+  gsaca_phase_stats const &operator[](gsaca_phase const p) const {
+    return phase[(uint32_t) p];
+  }
+
+  double total_seconds() const {
+    double result = 0;
+    for (auto const &s : phase) result += s.seconds;
+    return result;
+  }
+};
+
+// Writes one line per phase, as space separated key=value pairs (the format
+// of the benchmark output). Unavailable counters are omitted.
+inline void write_stats(std::ostream &out, gsaca_stats const &stats,
+                        char const *const prefix = "") {
+  for (uint32_t p = 0; p < gsaca_phase_count; ++p) {
+    auto const &s = stats.phase[p];
+    out << prefix << "phase=" << gsaca_phase_names[p]
+        << " seconds=" << s.seconds;
+    for (uint32_t c = 0; c < counter_count; ++c) {
+      if (s.counters.available[c]) {
+        out << " " << perf_counter_names[c] << "=" << s.counters.value[c];
+      }
+    }
+    if (s.counters.available[counter_cycles] &&
+        s.counters.available[counter_instructions] &&
+        s.counters.value[counter_cycles] > 0) {
+      out << " ipc=" << (double) s.counters.value[counter_instructions] /
+                        s.counters.value[counter_cycles];
+    }
+    out << "\n";
+  }
+}
+
+// Collects the wall time of each phase and, if counters are given, the
+// difference of the hardware counters between the begin and end of the
+// phase. Pass by value to gsaca_ds or gsaca_ds_par:
+//
+//   gsaca_stats stats;
+//   perf_counters counters(threads);
+//   gsaca_ds_par(text, sa, n, threads, 1, stats_observer{{}, &stats, &counters});
+struct stats_observer : no_observer {
+  gsaca_stats *stats;
+  perf_counters const *counters = nullptr;
+  std::chrono::steady_clock::time_point begin = {};
+  perf_counter_values begin_values = {};
+
+  void phase_begin(gsaca_phase const) {
+    if (counters != nullptr) begin_values = counters->read();
+    begin = std::chrono::steady_clock::now();
+  }
+
+  void phase_end(gsaca_phase const p) {
+    auto const end = std::chrono::steady_clock::now();
+    auto &s = (*stats)[p];
+    s.seconds = std::chrono::duration<double>(end - begin).count();
+    if (counters != nullptr) {
+      auto const end_values = counters->read();
+      for (uint32_t c = 0; c < counter_count; ++c) {
+        s.counters.available[c] =
+            begin_values.available[c] && end_values.available[c];
+        // scaling of multiplexed counters may be slightly non-monotonic
+        s.counters.value[c] = (s.counters.available[c] &&
+                               end_values.value[c] > begin_values.value[c])
+                              ? end_values.value[c] - begin_values.value[c]
+                              : 0;
+      }
+    }
+  }
+};
+
+}
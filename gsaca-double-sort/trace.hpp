@@ -0,0 +1,204 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "macros.hpp"
+
+// Thread timeline tracing of the parallel engine, enabled at compile time
+// with -DGSACA_TRACE. Without it, all tracing objects are empty and compile
+// to nothing.
+//
+// Every thread records into its own ring buffer of GSACA_TRACE_CAPACITY
+// events (the oldest events are overwritten), so recording needs no
+// synchronization. trace_dump writes all buffers in the Chrome trace event
+// format, which can be opened with chrome://tracing or ui.perfetto.dev.
+
+#ifndef GSACA_TRACE_CAPACITY
+#define GSACA_TRACE_CAPACITY (1ULL << 16)
+#endif
+
+namespace gsaca_lyndon {
+
+#ifdef GSACA_TRACE
+constexpr bool trace_enabled = true;
+#else
+constexpr bool trace_enabled = false;
+#endif
+
+namespace trace_internal {
+
+struct event {
+  char const *name;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+  uint64_t arg;
+};
+
+struct thread_buffer {
+  size_t tid;
+  uint64_t recorded = 0;
+  event *events = (event *) malloc(GSACA_TRACE_CAPACITY * sizeof(event));
+
+  explicit thread_buffer(size_t const id) : tid(id) {}
+
+  ~thread_buffer() {
+    free(events);
+  }
+};
+
+struct registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<thread_buffer>> buffers;
+  std::chrono::steady_clock::time_point const epoch =
+      std::chrono::steady_clock::now();
+};
+
+inline registry &global_registry() {
+  static registry instance;
+  return instance;
+}
+
+inline uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - global_registry().epoch).count();
+}
+
+// the buffers are owned by the registry, such that they survive the threads
+inline thread_buffer &local_buffer() {
+  thread_local thread_buffer *local = nullptr;
+  if (gsaca_unlikely(local == nullptr)) {
+    auto &r = global_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.buffers.emplace_back(new thread_buffer(r.buffers.size()));
+    local = r.buffers.back().get();
+  }
+  return *local;
+}
+
+inline void record(thread_buffer &buffer, char const *const name,
+                   uint64_t const begin_ns, uint64_t const end_ns,
+                   uint64_t const arg) {
+  buffer.events[buffer.recorded++ % GSACA_TRACE_CAPACITY] =
+      event{name, begin_ns, end_ns, arg};
+}
+
+} // namespace trace_internal
+
+// Records the lifetime of the object as one event of the calling thread.
+// The name must be a string literal (only the pointer is stored).
+class trace_scope {
+public:
+  gsaca_always_inline explicit trace_scope(char const *const name,
+                                           uint64_t const arg = 0) {
+    if constexpr (trace_enabled) {
+      buffer_ = &trace_internal::local_buffer();
+      name_ = name;
+      arg_ = arg;
+      begin_ns_ = trace_internal::now_ns();
+    }
+  }
+
+  trace_scope(trace_scope const &) = delete;
+
+  trace_scope &operator=(trace_scope const &) = delete;
+
+  gsaca_always_inline ~trace_scope() {
+    if constexpr (trace_enabled) {
+      trace_internal::record(*buffer_, name_, begin_ns_,
+                             trace_internal::now_ns(), arg_);
+    }
+  }
+
+private:
+  trace_internal::thread_buffer *buffer_ = nullptr;
+  char const *name_ = nullptr;
+  uint64_t arg_ = 0;
+  uint64_t begin_ns_ = 0;
+};
+
+// Records a stretch of consecutive small groups that are processed by a
+// single thread as one event (the argument is the number of groups).
+class trace_stretch {
+public:
+  explicit trace_stretch(char const *const name) : name_(name) {}
+
+  gsaca_always_inline void extend() {
+    if constexpr (trace_enabled) {
+      if (gsaca_unlikely(groups_ == 0)) begin_ns_ = trace_internal::now_ns();
+      ++groups_;
+    }
+  }
+
+  gsaca_always_inline void close() {
+    if constexpr (trace_enabled) {
+      if (groups_ > 0) {
+        trace_internal::record(trace_internal::local_buffer(), name_,
+                               begin_ns_, trace_internal::now_ns(), groups_);
+        groups_ = 0;
+      }
+    }
+  }
+
+  ~trace_stretch() {
+    close();
+  }
+
+private:
+  char const *name_;
+  uint64_t groups_ = 0;
+  uint64_t begin_ns_ = 0;
+};
+
+// Discards all recorded events. Must not run concurrently with tracing.
+inline void trace_clear() {
+  if constexpr (trace_enabled) {
+    auto &r = trace_internal::global_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto &buffer : r.buffers) buffer->recorded = 0;
+  }
+}
+
+// Writes all recorded events as Chrome trace JSON. Must not run
+// concurrently with tracing. Returns false if tracing is disabled or the
+// file cannot be written.
+inline bool trace_dump(char const *const path) {
+  if constexpr (!trace_enabled) {
+    (void) path;
+    return false;
+  } else {
+    FILE *const file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    auto &r = trace_internal::global_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (auto const &buffer : r.buffers) {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                    "\"tid\":%zu,\"args\":{\"name\":\"thread %zu\"}}",
+              first ? "" : ",\n", buffer->tid, buffer->tid);
+      first = false;
+      uint64_t const recorded = buffer->recorded;
+      uint64_t const begin = (recorded > GSACA_TRACE_CAPACITY)
+                             ? recorded - GSACA_TRACE_CAPACITY : 0;
+      for (uint64_t i = begin; i < recorded; ++i) {
+        auto const &e = buffer->events[i % GSACA_TRACE_CAPACITY];
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,"
+                      "\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"size\":%llu}}",
+                e.name, buffer->tid, e.begin_ns / 1000.0,
+                (e.end_ns - e.begin_ns) / 1000.0,
+                (unsigned long long) e.arg);
+      }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+  }
+}
+
+}
@@ -37,7 +37,11 @@ auto operator x(const T &b) const { \
   return *this x (UIntPair) b; \
 }
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
 #include <limits>
 #include <cstdint>
 #include "macros.hpp"
@@ -404,10 +408,73 @@ struct flag_type_none {
   }
 };
 
+// Keeps the flags (text[i - 1] < text[i]) in a bitvector indexed by text
+// position instead of the most significant bit of the entries, so that the
+// full range of the index type can be used. The flag of a suffix only depends
+// on its position, thus adding and removing flags are no-ops and only
+// is_flagged (an instance member) consults the bitvector.
+struct flag_type_side {
+  uint64_t const *bits = nullptr;
+
+  template<typename value_type>
+  static uint64_t *build(value_type const *const text, size_t const n,
+                         size_t const threads = 1) {
+    size_t const words = (n >> 6) + 1;
+    uint64_t *const result = (uint64_t *) malloc(words * sizeof(uint64_t));
+    #pragma omp parallel for num_threads(threads)
+    for (size_t w = 0; w < words; ++w) {
+      size_t const begin = std::max((size_t) 1, w << 6);
+      size_t const end = std::min(n, (w + 1) << 6);
+      uint64_t word = 0;
+      for (size_t i = begin; i < end; ++i) {
+        word |= ((uint64_t) (text[i - 1] < text[i])) << (i & 63);
+      }
+      result[w] = word;
+    }
+    return result;
+  }
+
+  template<typename T>
+  inline static T const &add_flag(T const &t) {
+    return t;
+  }
+
+  template<typename T>
+  inline static T const &conditional_add_flag(bool, T const &t) {
+    return t;
+  }
+
+  template<typename T>
+  inline static T const &remove_flag(T const &t) {
+    return t;
+  }
+
+  template<typename T>
+  inline bool is_flagged(T const &t) const {
+    uint64_t const i = t;
+    return (bits[i >> 6] >> (i & 63)) & 1;
+  }
+};
+
 template<bool use_flags>
 using flag_type = typename std::conditional<
     use_flags, flag_type_bitset, flag_type_none>::type;
 
+// The flags fit into the most significant bit if no entry uses it, and if
+// the entries are plain integers of the width of the count type (otherwise
+// the flags would be truncated in between).
+template<typename index_type, typename buffer_type, typename count_type>
+constexpr bool flag_bits_fit(size_t const n) {
+  if constexpr (!std::is_integral_v<index_type> ||
+                !std::is_integral_v<buffer_type> ||
+                sizeof(index_type) != sizeof(count_type) ||
+                sizeof(buffer_type) != sizeof(count_type)) {
+    return false;
+  } else {
+    return (((uint64_t) n) >> (sizeof(count_type) * 8 - 1)) == 0;
+  }
+}
+
 
 using std::uint8_t;
 using std::uint16_t;
@@ -425,7 +492,7 @@ using uint48_t = uint_internal::UIntPair<uint16_t>;
 static_assert(sizeof(uint40_t) == 5, "sizeof uint40 is wrong");
 static_assert(sizeof(uint48_t) == 6, "sizeof uint48 is wrong");
 
-using auto_buffer_type = nullptr_t;
+using auto_buffer_type = std::nullptr_t;
 template<typename buffer_type, typename index_type>
 using get_buffer_type =
 typename std::conditional<
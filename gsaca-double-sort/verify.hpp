@@ -0,0 +1,73 @@
+#pragma once
+
+#include <omp.h>
+#include <cstdlib>
+#include "uint_types.hpp"
+
+namespace gsaca_lyndon {
+
+// Linear time suffix array check (Burkhardt and Kärkkäinen): sa is the suffix
+// array of text iff it is a permutation of [0, n) and for all neighbors
+// a = sa[i], b = sa[i + 1] either text[a] < text[b], or text[a] == text[b]
+// and suffix a + 1 is smaller than suffix b + 1, i.e. a == n - 1 or
+// isa[a + 1] < isa[b + 1]. The second condition only needs the inverse
+// suffix array, which is computed into isa (n entries, overwritten). The
+// permutation check does not rely on the initial content of isa: every
+// position j must satisfy sa[isa[j]] == j.
+template<typename index_type, typename value_type, typename isa_type>
+static bool verify_sa_parallel(value_type const *const text,
+                               index_type const *const sa,
+                               isa_type *const isa, size_t const n,
+                               size_t threads) {
+  if (threads == 0) threads = omp_get_max_threads();
+  if (n == 0) return true;
+
+  bool in_range = true;
+  #pragma omp parallel for num_threads(threads) reduction(&&:in_range)
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t const pos = sa[i];
+    if (gsaca_likely(pos < n)) isa[pos] = i;
+    else in_range = false;
+  }
+  if (!in_range) return false;
+
+  bool permutation = true;
+  #pragma omp parallel for num_threads(threads) reduction(&&:permutation)
+  for (size_t j = 0; j < n; ++j) {
+    uint64_t const rank = isa[j];
+    permutation = permutation && rank < n && (uint64_t) sa[rank] == j;
+  }
+  if (!permutation) return false;
+
+  bool sorted = true;
+  #pragma omp parallel for num_threads(threads) reduction(&&:sorted)
+  for (size_t i = 1; i < n; ++i) {
+    uint64_t const a = sa[i - 1];
+    uint64_t const b = sa[i];
+    if (text[a] != text[b]) {
+      sorted = sorted && text[a] < text[b];
+    } else {
+      sorted = sorted && (b + 1 < n) &&
+               (a + 1 == n || (uint64_t) isa[a + 1] < (uint64_t) isa[b + 1]);
+    }
+  }
+  return sorted;
+}
+
+template<typename index_type, typename value_type>
+static bool verify_sa_parallel(value_type const *const text,
+                               index_type const *const sa, size_t const n,
+                               size_t const threads) {
+  index_type *const isa = (index_type *) malloc(n * sizeof(index_type));
+  bool const result = verify_sa_parallel(text, sa, isa, n, threads);
+  free(isa);
+  return result;
+}
+
+template<typename index_type, typename value_type>
+static bool verify_sa(value_type const *const text,
+                      index_type const *const sa, size_t const n) {
+  return verify_sa_parallel(text, sa, n, 1);
+}
+
+}
@@ -0,0 +1,479 @@
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../gsaca-double-sort.hpp"
+#include "../gsaca-double-sort/async.hpp"
+#include "../gsaca-double-sort/compressed_lcp.hpp"
+#include "../gsaca-double-sort/dedup.hpp"
+#include "../gsaca-double-sort/delta.hpp"
+#include "../gsaca-double-sort/dispatch.hpp"
+#include "../gsaca-double-sort/index_file.hpp"
+#include "../gsaca-double-sort/partial.hpp"
+#include "../gsaca-double-sort/pfp.hpp"
+#include "../gsaca-double-sort/phases.hpp"
+#include "../gsaca-double-sort/rle.hpp"
+#include "../gsaca-double-sort/sa_cache.hpp"
+#include "../gsaca-double-sort/sliding.hpp"
+#include "../gsaca-double-sort/stats.hpp"
+
+// Behavior checks for the headers in gsaca-double-sort. Every check builds
+// its inputs, runs one component and compares the result to a reference
+// (mostly gsaca_ds on the same text, or a naive computation). Prints one
+// line per check and exits with 1 if any check fails.
+//
+// usage: check [scratch directory, default /tmp]
+
+namespace {
+
+using namespace gsaca_lyndon;
+
+std::string scratch = "/tmp";
+
+uint64_t next_random(uint64_t &state) {
+  state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return state >> 33;
+}
+
+// text with sentinels and interior symbols 1, ..., sigma
+std::vector<uint8_t> random_text(size_t const n, size_t const sigma,
+                                 uint64_t state) {
+  std::vector<uint8_t> text(n, 0);
+  for (size_t i = 1; i < n - 1; ++i) {
+    text[i] = 1 + next_random(state) % sigma;
+  }
+  return text;
+}
+
+// text with sentinels whose interior repeats the first period symbols
+std::vector<uint8_t> periodic_text(size_t const n, size_t const period) {
+  std::vector<uint8_t> text(n);
+  uint64_t state = 42;
+  for (size_t i = 1; i < n - 1; ++i) {
+    if (i <= period) {
+      text[i] = 1 + next_random(state) % 200;
+    } else {
+      text[i] = text[i - period];
+    }
+  }
+  text[0] = text[n - 1] = 0;
+  return text;
+}
+
+std::vector<uint32_t> reference_sa(std::vector<uint8_t> const &text) {
+  std::vector<uint32_t> sa(text.size());
+  gsaca_ds(text.data(), sa.data(), text.size());
+  return sa;
+}
+
+std::vector<uint8_t> reference_bwt(std::vector<uint8_t> const &text,
+                                   std::vector<uint32_t> const &sa) {
+  std::vector<uint8_t> bwt(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    bwt[i] = (sa[i] > 0) ? text[sa[i] - 1] : text.back();
+  }
+  return bwt;
+}
+
+// runs of length 0 to 5, some of them adjacent with equal symbols
+bool check_rle() {
+  uint64_t state = 1;
+  std::vector<uint8_t> symbols;
+  std::vector<uint64_t> lengths;
+  std::vector<uint8_t> text(1, 0);
+  for (size_t k = 0; k < 3000; ++k) {
+    symbols.push_back(1 + next_random(state) % 3);
+    lengths.push_back(next_random(state) % 6);
+    text.insert(text.end(), lengths.back(), symbols.back());
+  }
+  text.push_back(0);
+  auto const ref = reference_sa(text);
+
+  std::vector<uint32_t> sa(text.size());
+  rle_gsaca_ds(symbols.data(), lengths.data(), symbols.size(), sa.data());
+  if (sa != ref) return false;
+
+  auto const bwt = reference_bwt(text, ref);
+  uint64_t i = 0;
+  for (auto const &run : rle_bwt(symbols.data(), lengths.data(),
+                                 symbols.size())) {
+    if (run.sa != ref[i]) return false;
+    for (uint64_t j = 0; j < run.length; ++j, ++i) {
+      if (bwt[i] != run.symbol) return false;
+    }
+  }
+  return i == text.size();
+}
+
+// substitutions (equal lengths) and an insertion (common prefix and suffix)
+bool check_delta() {
+  auto const old_text = random_text(20000, 4, 2);
+  auto const old_sa = reference_sa(old_text);
+  std::vector<uint32_t> old_isa(old_text.size());
+  for (size_t i = 0; i < old_sa.size(); ++i) old_isa[old_sa[i]] = i;
+
+  auto substituted = old_text;
+  for (size_t i = 1000; i < 19000; i += 1500) substituted[i] = 1;
+  auto inserted = old_text;
+  inserted.insert(inserted.begin() + 7000, {4, 3, 2, 1, 2});
+
+  for (auto const &new_text : {substituted, inserted}) {
+    size_t const n = new_text.size();
+    std::vector<uint32_t> sa(n), isa(n);
+    if (!delta_gsaca_ds(old_text.data(), old_sa.data(), old_isa.data(),
+                        old_text.size(), new_text.data(), sa.data(), n,
+                        isa.data()) ||
+        sa != reference_sa(new_text)) {
+      return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (isa[sa[i]] != i) return false;
+    }
+  }
+  return true;
+}
+
+// nested and overlapping patterns against the intervals of the full array
+bool check_partial() {
+  auto const text = random_text(30000, 3, 3);
+  size_t const n = text.size();
+  auto const ref = reference_sa(text);
+  std::vector<std::vector<uint8_t>> const patterns = {
+      {2, 1}, {1}, {1, 3, 3}, {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3}};
+
+  std::vector<uint32_t> slice;
+  std::vector<partial_interval> intervals;
+  if (!partial_gsaca_ds(text.data(), n, patterns, slice, intervals)) {
+    return false;
+  }
+  auto const starts_with = [&](uint64_t const i,
+                               std::vector<uint8_t> const &pattern) {
+      for (size_t j = 0; j < pattern.size(); ++j) {
+        if (i + j >= n || text[i + j] != pattern[j]) return false;
+      }
+      return true;
+  };
+  std::vector<uint32_t> expected;
+  for (uint32_t const i : ref) {
+    for (auto const &pattern : patterns) {
+      if (starts_with(i, pattern)) {
+        expected.push_back(i);
+        break;
+      }
+    }
+  }
+  if (slice != expected) return false;
+  for (size_t p = 0; p < patterns.size(); ++p) {
+    uint64_t const sa_begin = intervals[p].sa_begin;
+    for (uint64_t k = intervals[p].begin; k < intervals[p].end; ++k) {
+      if (ref[sa_begin + k - intervals[p].begin] != slice[k] ||
+          !starts_with(slice[k], patterns[p])) {
+        return false;
+      }
+    }
+    uint64_t const sa_end = sa_begin + intervals[p].end - intervals[p].begin;
+    if ((sa_begin > 0 && starts_with(ref[sa_begin - 1], patterns[p])) ||
+        (sa_end < n && starts_with(ref[sa_end], patterns[p]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_phases() {
+  auto const text = random_text(100000, 4, 4);
+  size_t const n = text.size();
+  std::vector<uint32_t> sa(n);
+  std::vector<phases::buffer_type<uint32_t>> isa(n);
+  auto groups = phases::sort_by_prefix(text.data(), sa.data(), n, 2);
+  if (!phases::check_initial_groups(text.data(), sa.data(), n, groups, 2)) {
+    return false;
+  }
+  auto const phase_2_groups = phases::phase_1(sa.data(), isa.data(), groups);
+  phases::phase_2(sa.data(), isa.data(), n, phase_2_groups);
+  return sa == reference_sa(text);
+}
+
+bool check_dispatch() {
+  if (select_index_width(1ULL << 33, index_width_policy::smallest) != 5 ||
+      select_index_width(1ULL << 33, index_width_policy::aligned) != 8 ||
+      select_index_width(1000, index_width_policy::wide) != 8) {
+    return false;
+  }
+  auto const text = random_text(50000, 20, 5);
+  auto const ref = reference_sa(text);
+  for (auto const policy : {index_width_policy::smallest,
+                            index_width_policy::wide}) {
+    auto const sa = gsaca_ds_any(text.data(), text.size(), policy);
+    if (!sa || sa.size() != text.size() ||
+        sa.width() != select_index_width(text.size(), policy)) {
+      return false;
+    }
+    for (size_t i = 0; i < ref.size(); ++i) {
+      if (sa[i] != ref[i]) return false;
+    }
+  }
+  return true;
+}
+
+// blocks shorter than the window, longer than it, and a long dirty tail
+bool check_sliding() {
+  size_t const window = 500;
+  sliding_window_sa<uint32_t, uint8_t> sliding(window);
+  std::vector<uint8_t> stream;
+  uint64_t state = 6;
+  for (size_t step = 0; step < 60; ++step) {
+    size_t const length = (step % 10 == 9) ? window + 100
+                                           : 1 + next_random(state) % 40;
+    std::vector<uint8_t> block(length);
+    for (auto &c : block) {
+      c = (step % 20 < 10) ? 1 + next_random(state) % 2 : 1;
+    }
+    stream.insert(stream.end(), block.begin(), block.end());
+    sliding.advance(block.data(), length);
+
+    size_t const m = std::min(window, stream.size());
+    std::vector<uint8_t> text(m + 2, 0);
+    std::copy(stream.end() - m, stream.end(), text.begin() + 1);
+    auto const ref = reference_sa(text);
+    std::vector<uint32_t> sa(m + 2), isa(m + 2);
+    if (sliding.size() != m + 2 || sliding.offset() != stream.size() - m ||
+        !std::equal(text.begin(), text.end(), sliding.text())) {
+      return false;
+    }
+    sliding.copy_sa(sa.data());
+    sliding.copy_isa(isa.data());
+    if (sa != ref) return false;
+    for (size_t i = 0; i < m + 2; ++i) {
+      if (isa[ref[i]] != i || sliding.suffix(i) != ref[i] ||
+          sliding.rank(ref[i]) != i) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// copies of one block with a few mutations each
+bool check_pfp() {
+  auto const block = random_text(3002, 4, 7);
+  std::vector<uint8_t> text(1, 0);
+  uint64_t state = 7;
+  for (size_t copy = 0; copy < 20; ++copy) {
+    size_t const begin = text.size();
+    text.insert(text.end(), block.begin() + 1, block.end() - 1);
+    for (size_t k = 0; k < 10; ++k) {
+      text[begin + next_random(state) % 3000] = 1 + next_random(state) % 4;
+    }
+  }
+  text.push_back(0);
+  auto const ref = reference_sa(text);
+
+  pfp_config config;
+  config.window = 6;
+  config.trigger_modulus = 32;
+  std::vector<uint8_t> bwt;
+  bool samples_ok = true;
+  pfp_stats stats;
+  bool const ok = pfp_bwt(
+      text.data(), text.size(), config,
+      [&](uint8_t const symbol, uint64_t const length) {
+          bwt.insert(bwt.end(), length, symbol);
+      },
+      [&](uint64_t const position, uint64_t const sa, bool) {
+          samples_ok &= position < ref.size() && ref[position] == sa;
+      },
+      &stats);
+  return ok && samples_ok && stats.phrases > 1 &&
+         bwt == reference_bwt(text, ref);
+}
+
+// values above 255 need more than one DAC level
+bool check_compressed_lcp() {
+  auto const text = periodic_text(5000, 1000);
+  size_t const n = text.size();
+  auto const ref = reference_sa(text);
+  std::vector<uint64_t> plcp(n, 0);
+  for (size_t k = 1; k < n; ++k) {
+    uint64_t const a = ref[k - 1], b = ref[k];
+    uint64_t l = 0;
+    while (a + l < n - 1 && b + l < n - 1 && text[a + l] != 0 &&
+           text[a + l] == text[b + l]) {
+      ++l;
+    }
+    plcp[b] = l;
+  }
+  plcp[0] = plcp[n - 1] = 0;
+
+  succinct_plcp succinct;
+  dac_lcp dac;
+  if (!compressed_lcp(text.data(), ref.data(), n, succinct, &dac)) {
+    return false;
+  }
+  if (succinct.size() != n || dac.size() != n) return false;
+  uint64_t i = 0;
+  for (auto it = succinct.begin(); it != succinct.end(); ++it, ++i) {
+    if (*it != plcp[i] || succinct[i] != plcp[i]) return false;
+  }
+  uint64_t k = 0;
+  for (auto it = dac.begin(); it != dac.end(); ++it, ++k) {
+    if (*it != plcp[ref[k]] || dac[k] != plcp[ref[k]]) return false;
+  }
+  return i == n && k == n;
+}
+
+bool check_async() {
+  gsaca_job idle;
+  if (idle.valid() || idle.ready() || idle.wait()) return false;
+
+  auto const text = random_text(200000, 4, 8);
+  std::vector<uint32_t> sa(text.size());
+  auto job = gsaca_ds_async(text.data(), sa.data(), text.size());
+  if (!job.wait() || !job.ready()) return false;
+  auto const progress = job.progress();
+  if (progress.stage != gsaca_stage::done || progress.fraction != 1.0 ||
+      sa != reference_sa(text)) {
+    return false;
+  }
+
+  // cancelled at some point, the stage reflects the outcome
+  auto cancelled = gsaca_ds_async(text.data(), sa.data(), text.size());
+  cancelled.cancel();
+  bool const completed = cancelled.wait();
+  return cancelled.progress().stage ==
+         (completed ? gsaca_stage::done : gsaca_stage::cancelled);
+}
+
+bool check_sa_cache() {
+  std::string const directory = scratch + "/gsaca-check-cache-" +
+                                 std::to_string(getpid());
+  auto const text = random_text(100000, 30, 9);
+  auto const ref = reference_sa(text);
+  bool ok;
+  {
+    sa_cache cache(directory, 1ULL << 30);
+    index_file_options options;
+    options.bwt = true;
+    auto const built = cache.get_or_build<uint32_t>(text.data(), text.size(),
+                                                    options);
+    auto const hit = cache.get_or_build<uint32_t>(text.data(), text.size(),
+                                                  options);
+    ok = built && hit && cache.misses() == 1 && cache.hits() == 1 &&
+         std::equal(ref.begin(), ref.end(), hit.sa()) &&
+         hit.matches_text(text.data(), text.size()) && hit.bwt() != nullptr &&
+         cache.size() > 0;
+  }
+  std::error_code ec;
+  std::filesystem::remove_all(directory, ec);
+  return ok;
+}
+
+// a block of document 0 is copied into document 1
+bool check_dedup() {
+  uint8_t const separator = 255;
+  auto const first = random_text(302, 200, 10);
+  auto const second = random_text(402, 200, 11);
+  std::vector<uint8_t> text(first.begin(), first.end() - 1);
+  text.push_back(separator);
+  uint64_t const copy_begin = text.size() + 100;
+  text.insert(text.end(), second.begin() + 1, second.begin() + 101);
+  text.insert(text.end(), first.begin() + 51, first.begin() + 151);
+  text.insert(text.end(), second.begin() + 101, second.end());
+  uint64_t begin = copy_begin, end = copy_begin + 100;
+  // the copy may extend by chance
+  while (text[begin - 1] == text[51 - (copy_begin - begin) - 1]) --begin;
+  while (text[end] == text[151 + (end - copy_begin - 100)]) ++end;
+
+  auto const ref = reference_sa(text);
+  for (auto const &ranges : {
+      find_duplicates_par(text.data(), ref.data(), text.size(), 20,
+                          separator),
+      dedup_par(text.data(), text.size(), 20, separator)}) {
+    if (ranges.size() != 1 || ranges[0].document != 1 ||
+        ranges[0].begin != begin || ranges[0].end != end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_stats() {
+  auto const text = random_text(100000, 4, 12);
+  std::vector<uint32_t> sa(text.size());
+  gsaca_stats stats;
+  gsaca_ds(text.data(), sa.data(), text.size(), 1, stats_observer{{}, &stats});
+  std::ostringstream out;
+  write_stats(out, stats, "check ");
+  std::string const lines = out.str();
+  if (sa != reference_sa(text) ||
+      std::count(lines.begin(), lines.end(), '\n') != gsaca_phase_count) {
+    return false;
+  }
+  for (uint32_t p = 0; p < gsaca_phase_count; ++p) {
+    if (stats.phase[p].seconds < 0 ||
+        lines.find(std::string("phase=") + gsaca_phase_names[p]) ==
+        std::string::npos) {
+      return false;
+    }
+  }
+  return stats.total_seconds() > 0;
+}
+
+// the periodic fast path must not report the suffix array of its reduced
+// text to the observer (the fingerprint of the file would cover garbage)
+bool check_index_file_periodic() {
+  size_t const n = 1ULL << 21;
+  auto const text = periodic_text(n, 200000);
+  std::string const path = scratch + "/gsaca-check-" +
+                           std::to_string(getpid()) + ".gsidx";
+  index_file_options options;
+  options.isa = options.lcp = options.bwt = true;
+  bool ok = build_index_file<uint32_t>(path.c_str(), text.data(), n, options);
+  if (ok) {
+    mapped_index<uint32_t, uint8_t> index(path.c_str());
+    ok = index && index.verify_checksums() &&
+         verify_sa(text.data(), index.sa(), n);
+  }
+  std::remove(path.c_str());
+  return ok;
+}
+
+struct named_check {
+  char const *name;
+  bool (*run)();
+};
+
+named_check const checks[] = {
+    {"rle", check_rle},
+    {"delta", check_delta},
+    {"partial", check_partial},
+    {"phases", check_phases},
+    {"dispatch", check_dispatch},
+    {"sliding", check_sliding},
+    {"pfp", check_pfp},
+    {"compressed_lcp", check_compressed_lcp},
+    {"async", check_async},
+    {"sa_cache", check_sa_cache},
+    {"dedup", check_dedup},
+    {"stats", check_stats},
+    {"index_file periodic", check_index_file_periodic},
+};
+
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) scratch = argv[1];
+  size_t failed = 0;
+  for (auto const &check : checks) {
+    bool const ok = check.run();
+    std::cout << check.name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+    failed += !ok;
+  }
+  std::cout << failed << " of " << std::size(checks) << " checks failed"
+            << std::endl;
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+g++ dedup.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o dedup
+
+g++ gsaca-daemon.cpp \
+-std=c++17 -fopenmp -latomic -pthread \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o gsaca-daemon
+
+g++ verify-sa.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o verify-sa
+
+g++ check.cpp \
+-std=c++17 -fopenmp -latomic \
+-O3 -march=native -funroll-loops -DNDEBUG \
+-Wall -Wextra -Wpedantic \
+-o check
@@ -0,0 +1,39 @@
+#include <cstdlib>
+#include <iostream>
+#include "../gsaca-double-sort/dedup.hpp"
+#include "../gsaca-double-sort/mapped_text.hpp"
+
+// Reports all duplicated ranges of length >= L of a corpus file. Documents
+// are separated by the separator byte (default: newline). Each output line
+// contains the document id and the byte range [begin, end) within the file.
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+              << " <corpus> <L> [separator byte = 10] [threads = 0]"
+              << std::endl;
+    return 1;
+  }
+
+  gsaca_lyndon::mapped_text corpus(argv[1]);
+  if (!corpus) {
+    std::cerr << "cannot map " << argv[1] << std::endl;
+    return 1;
+  }
+
+  size_t const L = std::strtoull(argv[2], nullptr, 10);
+  uint8_t const separator = (argc > 3) ? std::atoi(argv[3]) : '\n';
+  size_t const threads = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 0;
+
+  auto const duplicates = gsaca_lyndon::dedup_par(
+      corpus.text(), corpus.size(), L, separator, threads);
+
+  uint64_t duplicated_bytes = 0;
+  for (auto const &range : duplicates) {
+    std::cout << range.document << " " << range.begin - 1 << " "
+              << range.end - 1 << "\n";
+    duplicated_bytes += range.end - range.begin;
+  }
+  std::cerr << duplicates.size() << " ranges, " << duplicated_bytes
+            << " of " << corpus.size() - 2 << " bytes duplicated" << std::endl;
+  return 0;
+}
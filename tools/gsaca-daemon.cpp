@@ -0,0 +1,378 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../gsaca-double-sort/daemon_protocol.hpp"
+#include "../gsaca-double-sort/parallel/gsaca-ds-par.hpp"
+#include "../gsaca-double-sort/sequential/gsaca-ds.hpp"
+
+// Local suffix sorting daemon. It owns one OpenMP team, so services that
+// submit jobs (see daemon_protocol.hpp) do not oversubscribe the machine.
+//
+// Scheduling: jobs with n < small_threshold are small, all others are big.
+// The next job is the one with the highest effective priority, which is the
+// requested priority plus one for every aging_interval spent in the queue
+// (ties: small before big, then FIFO). Thus big jobs cannot be starved by a
+// stream of small ones. Big jobs run one at a time with all threads using
+// gsaca_ds_par. Small jobs are batched: up to one per thread run
+// concurrently, each using the sequential gsaca_ds.
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using gsaca_lyndon::daemon_request;
+using gsaca_lyndon::daemon_response;
+using gsaca_lyndon::daemon_stats;
+namespace protocol = gsaca_lyndon::daemon_protocol;
+
+constexpr auto aging_interval = std::chrono::milliseconds(500);
+// requests are read on the accept thread, a silent client may block it only
+// this long
+constexpr timeval receive_timeout = {1, 0};
+
+struct job {
+  int connection;
+  int text_fd;
+  int sa_fd;
+  daemon_request request;
+  clock_type::time_point submitted;
+  uint64_t sequence;
+};
+
+class scheduler {
+public:
+  scheduler(size_t const threads, uint64_t const small_threshold)
+      : threads_(threads), small_threshold_(small_threshold) {}
+
+  void push(job const &j) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job queued = j;
+      queued.sequence = sequence_++;
+      is_small(queued) ? small_.push_back(queued) : big_.push_back(queued);
+    }
+    cv_.notify_one();
+  }
+
+  // blocks until jobs are available, returns an empty batch on shutdown
+  std::vector<job> next_batch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] {
+        return stop_ || !small_.empty() || !big_.empty();
+    });
+    std::vector<job> batch;
+    if (stop_) return batch;
+
+    auto const now = clock_type::now();
+    size_t const best_small = best(small_, now);
+    size_t const best_big = best(big_, now);
+
+    if (best_big < big_.size() &&
+        (best_small == small_.size() ||
+         effective_priority(big_[best_big], now) >
+         effective_priority(small_[best_small], now))) {
+      batch.push_back(big_[best_big]);
+      big_.erase(big_.begin() + best_big);
+    } else {
+      int64_t const big_priority = (best_big < big_.size())
+                                   ? effective_priority(big_[best_big], now)
+                                   : INT64_MIN;
+      while (batch.size() < threads_ && !small_.empty()) {
+        size_t const next = best(small_, now);
+        if (!batch.empty() &&
+            effective_priority(small_[next], now) < big_priority) {
+          break;
+        }
+        batch.push_back(small_[next]);
+        small_.erase(small_.begin() + next);
+      }
+    }
+    stats_.running = batch.size();
+    stats_.queued_small = small_.size();
+    stats_.queued_big = big_.size();
+    return batch;
+  }
+
+  void finished(job const &j, daemon_response const &response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (response.status == protocol::status_ok) {
+      ++stats_.jobs_completed;
+      stats_.total_bytes_sorted += j.request.n;
+    } else {
+      ++stats_.jobs_failed;
+    }
+    stats_.total_queue_ns += response.queue_ns;
+    stats_.max_queue_ns = std::max(stats_.max_queue_ns, response.queue_ns);
+    stats_.total_run_ns += response.run_ns;
+    stats_.max_run_ns = std::max(stats_.max_run_ns, response.run_ns);
+    stats_.running -= (stats_.running > 0);
+  }
+
+  daemon_stats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    daemon_stats result = stats_;
+    result.queued_small = small_.size();
+    result.queued_big = big_.size();
+    return result;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  // removes all queued jobs, used on shutdown
+  std::vector<job> drain() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<job> result = std::move(small_);
+    result.insert(result.end(), big_.begin(), big_.end());
+    small_.clear();
+    big_.clear();
+    return result;
+  }
+
+  bool is_small(job const &j) const {
+    return j.request.n < small_threshold_;
+  }
+
+private:
+  static int64_t effective_priority(job const &j,
+                                    clock_type::time_point const now) {
+    return (int64_t) j.request.priority + (now - j.submitted) / aging_interval;
+  }
+
+  static size_t best(std::vector<job> const &queue,
+                     clock_type::time_point const now) {
+    size_t result = queue.size();
+    for (size_t i = 0; i < queue.size(); ++i) {
+      if (result == queue.size() ||
+          effective_priority(queue[i], now) >
+          effective_priority(queue[result], now) ||
+          (effective_priority(queue[i], now) ==
+           effective_priority(queue[result], now) &&
+           queue[i].sequence < queue[result].sequence)) {
+        result = i;
+      }
+    }
+    return result;
+  }
+
+  size_t const threads_;
+  uint64_t const small_threshold_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<job> small_;
+  std::vector<job> big_;
+  uint64_t sequence_ = 0;
+  bool stop_ = false;
+  daemon_stats stats_ = {};
+};
+
+template<typename index_type>
+void sort(uint8_t const *const text, void *const sa, size_t const n,
+          bool const parallel, size_t const threads) {
+  if (parallel) {
+    gsaca_lyndon::gsaca_ds_par(text, (index_type *) sa, n, threads, 2);
+  } else {
+    gsaca_lyndon::gsaca_ds(text, (index_type *) sa, n, 2);
+  }
+}
+
+// suffix array entries are below n
+bool fits_index(uint64_t const n, uint32_t const index_bytes) {
+  return index_bytes == 8 || (n >> (8 * index_bytes)) == 0;
+}
+
+// sentinels at both ends and no other zeros, as gsaca_ds requires
+bool valid_text(uint8_t const *const text, size_t const n) {
+  return text[0] == 0 && text[n - 1] == 0 &&
+         memchr(text + 1, 0, n - 2) == nullptr;
+}
+
+daemon_response run(job const &j, bool const parallel, size_t const threads) {
+  daemon_response response = {};
+  auto const start = clock_type::now();
+  response.queue_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      start - j.submitted).count();
+
+  // The descriptors come from untrusted clients: sealing keeps the mappings
+  // valid while sorting (no SIGBUS if the client truncates a file), and the
+  // text is checked against the preconditions of gsaca_ds after mapping it.
+  size_t const n = j.request.n;
+  int const text_seals = fcntl(j.text_fd, F_GET_SEALS);
+  int const sa_seals = fcntl(j.sa_fd, F_GET_SEALS);
+  if (text_seals < 0 || sa_seals < 0 ||
+      (text_seals & protocol::text_seals) != protocol::text_seals ||
+      (sa_seals & protocol::output_seals) != protocol::output_seals) {
+    response.status = protocol::status_not_sealed;
+    return response;
+  }
+  size_t const sa_bytes = n * j.request.index_bytes;
+  struct stat text_stat, sa_stat;
+  if (n < 3 || !fits_index(n, j.request.index_bytes) ||
+      fstat(j.text_fd, &text_stat) != 0 ||
+      fstat(j.sa_fd, &sa_stat) != 0 || (size_t) text_stat.st_size < n ||
+      (size_t) sa_stat.st_size < sa_bytes) {
+    response.status = protocol::status_bad_request;
+    return response;
+  }
+
+  void *const text = mmap(nullptr, n, PROT_READ, MAP_SHARED, j.text_fd, 0);
+  void *const sa = mmap(nullptr, sa_bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, j.sa_fd, 0);
+  if (text == MAP_FAILED || sa == MAP_FAILED) {
+    response.status = protocol::status_map_failed;
+  } else if (!valid_text((uint8_t const *) text, n)) {
+    response.status = protocol::status_bad_text;
+  } else {
+    uint8_t const *const t = (uint8_t const *) text;
+    switch (j.request.index_bytes) {
+      case 4:
+        sort<uint32_t>(t, sa, n, parallel, threads);
+        break;
+      case 5:
+        sort<gsaca_lyndon::uint40_t>(t, sa, n, parallel, threads);
+        break;
+      default:
+        sort<uint64_t>(t, sa, n, parallel, threads);
+    }
+    response.status = protocol::status_ok;
+  }
+  if (text != MAP_FAILED) munmap(text, n);
+  if (sa != MAP_FAILED) munmap(sa, sa_bytes);
+
+  response.run_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock_type::now() - start).count();
+  return response;
+}
+
+void reply(job const &j, daemon_response const &response) {
+  gsaca_lyndon::daemon_internal::send_message(j.connection, &response,
+                                              sizeof(response));
+  close(j.connection);
+  close(j.text_fd);
+  close(j.sa_fd);
+}
+
+int listen_fd = -1;
+std::atomic<bool> shutting_down = false;
+
+void handle_signal(int) {
+  shutting_down = true;
+  shutdown(listen_fd, SHUT_RDWR);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0]
+              << " <socket> [threads = 0] [small job threshold = 1048576]"
+              << std::endl;
+    return 1;
+  }
+  char const *const socket_path = argv[1];
+  size_t const requested = (argc > 2) ? std::strtoull(argv[2], nullptr, 10)
+                                      : 0;
+  size_t const threads = (requested == 0) ? omp_get_max_threads() : requested;
+  uint64_t const small_threshold =
+      (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : (1ULL << 20);
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+  unlink(socket_path);
+  if (listen_fd < 0 || bind(listen_fd, (sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(listen_fd, 128) != 0) {
+    std::cerr << "cannot listen on " << socket_path << std::endl;
+    return 1;
+  }
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+
+  scheduler jobs(threads, small_threshold);
+
+  std::thread executor([&] {
+      while (true) {
+        auto const batch = jobs.next_batch();
+        if (batch.empty()) break;
+
+        if (batch.size() == 1 && !jobs.is_small(batch[0])) {
+          auto const response = run(batch[0], true, threads);
+          jobs.finished(batch[0], response);
+          reply(batch[0], response);
+        } else {
+          #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+          for (size_t i = 0; i < batch.size(); ++i) {
+            auto const response = run(batch[i], false, 1);
+            jobs.finished(batch[i], response);
+            reply(batch[i], response);
+          }
+        }
+      }
+  });
+
+  while (!shutting_down) {
+    int const connection = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout,
+               sizeof(receive_timeout));
+    job j = {};
+    int fds[2] = {-1, -1};
+    size_t fd_count = 0;
+    bool const received = gsaca_lyndon::daemon_internal::receive_message(
+        connection, &j.request, sizeof(j.request), fds, &fd_count);
+    bool const valid = received && j.request.magic == protocol::magic;
+
+    if (valid && j.request.type == protocol::request_stats) {
+      daemon_stats const stats = jobs.stats();
+      gsaca_lyndon::daemon_internal::send_message(connection, &stats,
+                                                  sizeof(stats));
+      close(connection);
+    } else if (valid && j.request.type == protocol::request_sort &&
+               fd_count == 2 &&
+               (j.request.index_bytes == 4 || j.request.index_bytes == 5 ||
+                j.request.index_bytes == 8)) {
+      j.connection = connection;
+      j.text_fd = fds[0];
+      j.sa_fd = fds[1];
+      j.submitted = clock_type::now();
+      jobs.push(j);
+    } else {
+      daemon_response response = {};
+      response.status = protocol::status_bad_request;
+      gsaca_lyndon::daemon_internal::send_message(connection, &response,
+                                                  sizeof(response));
+      for (size_t i = 0; i < fd_count; ++i) close(fds[i]);
+      close(connection);
+    }
+  }
+
+  jobs.stop();
+  executor.join();
+  for (auto const &j : jobs.drain()) {
+    daemon_response response = {};
+    response.status = protocol::status_shutting_down;
+    reply(j, response);
+  }
+  close(listen_fd);
+  unlink(socket_path);
+  return 0;
+}
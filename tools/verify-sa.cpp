@@ -0,0 +1,88 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "../gsaca-double-sort/mapped_text.hpp"
+#include "../gsaca-double-sort/verify.hpp"
+
+// Checks a suffix array file against its text in linear time (see
+// verify.hpp). The suffix array consists of n entries of the given width in
+// native byte order. If the text file already contains both sentinels, n is
+// its size; otherwise n is its size plus two and the sentinels are added
+// (as by mapped_text). Exits with 0 iff the suffix array is correct.
+
+namespace {
+
+template<typename index_type>
+bool verify(uint8_t const *const text, void const *const sa, size_t const n,
+            size_t const threads) {
+  return gsaca_lyndon::verify_sa_parallel(text, (index_type const *) sa, n,
+                                          threads);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+              << " <text> <suffix array> [index bytes = 4] [threads = 0]"
+              << std::endl;
+    return 2;
+  }
+  size_t const index_bytes = (argc > 3) ? std::strtoull(argv[3], nullptr, 10)
+                                        : 4;
+  size_t const threads = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 0;
+  if (index_bytes != 4 && index_bytes != 5 && index_bytes != 8) {
+    std::cerr << "index bytes must be 4, 5 or 8" << std::endl;
+    return 2;
+  }
+
+  gsaca_lyndon::mapped_text const mapped(argv[1]);
+  int const fd = open(argv[2], O_RDONLY);
+  struct stat st;
+  if (!mapped || fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+    std::cerr << "cannot map input files" << std::endl;
+    return 2;
+  }
+  size_t const sa_bytes = st.st_size;
+  void *const sa = mmap(nullptr, sa_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (sa == MAP_FAILED) {
+    std::cerr << "cannot map " << argv[2] << std::endl;
+    return 2;
+  }
+
+  uint8_t const *text = mapped.text();
+  size_t n = mapped.size();
+  if (sa_bytes == (n - 2) * index_bytes) {
+    text += 1;
+    n -= 2;
+  } else if (sa_bytes != n * index_bytes) {
+    std::cerr << "suffix array size does not match the text" << std::endl;
+    munmap(sa, sa_bytes);
+    return 2;
+  }
+
+  auto const begin = std::chrono::steady_clock::now();
+  bool correct;
+  switch (index_bytes) {
+    case 4:
+      correct = verify<uint32_t>(text, sa, n, threads);
+      break;
+    case 5:
+      correct = verify<gsaca_lyndon::uint40_t>(text, sa, n, threads);
+      break;
+    default:
+      correct = verify<uint64_t>(text, sa, n, threads);
+  }
+  double const seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+  munmap(sa, sa_bytes);
+
+  std::cerr << (correct ? "correct" : "INCORRECT") << " (n=" << n << ", "
+            << seconds << "s)" << std::endl;
+  return correct ? 0 : 1;
+}